@@ -0,0 +1,197 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "m_utils.h"
+
+// Writes a file with write(path) to `<file_path>.tmp`, then renames it over
+// `<file_path>`, so a crash mid-write leaves the previous file intact. Paths are
+// relative to output_dir.
+inline bool write_atomically(const std::string& file_path, const std::function<bool(const std::string&)>& write) {
+    std::string tmp_path = file_path + ".tmp";
+    if (!write(tmp_path)) return false;
+
+    // Make the data durable before the rename publishes it
+    std::string tmp_full = output_dir + tmp_path;
+    int fd = ::open(tmp_full.c_str(), O_RDONLY);
+    bool synced = fd >= 0 && ::fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    if (!synced || std::rename(tmp_full.c_str(), (output_dir + file_path).c_str()) != 0) {
+        std::cerr << "Failed to publish checkpoint " << file_path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// When AsyncCheckpointer takes a snapshot: every `episodes` episodes and/or every
+// `interval` of wall-clock time, whichever comes first. Zero disables a trigger.
+struct CheckpointSchedule {
+    int episodes = 0;
+    std::chrono::seconds interval{0};
+};
+
+// Periodic checkpointing off the training thread. On a due episode, snapshot()
+// copies the learning state on the training thread (between episodes, so the copy
+// is consistent), and a background thread writes it with write(snapshot, path)
+// through write_atomically. If a write is still running when the next
+// snapshot is due, the newer snapshot replaces any queued one, so training never
+// waits for disk. Paths are relative to output_dir, like the save functions.
+//
+// Training does pause for the copy itself, which grows with the state being copied;
+// longest_pause() reports the worst one. Copying a large table allocates and faults
+// in fresh pages every time. With a refresh(buffer) function, written snapshots are
+// recycled and refreshed in place (e.g. `buffer = strategy`, which reuses the
+// vectors' storage) instead.
+template <typename Snapshot>
+class AsyncCheckpointer {
+   public:
+    using SnapshotFunction = std::function<Snapshot()>;
+    using RefreshFunction = std::function<void(Snapshot&)>;
+    using WriteFunction = std::function<bool(const Snapshot&, const std::string&)>;
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string m_file_path;
+    CheckpointSchedule m_schedule;
+    SnapshotFunction m_snapshot;
+    WriteFunction m_write;
+    RefreshFunction m_refresh;
+
+    int m_last_episode{0};
+    Clock::time_point m_last_time{Clock::now()};
+    Clock::duration m_longest_pause{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::optional<Snapshot> m_pending;
+    std::optional<Snapshot> m_spare;  // a written snapshot kept for refresh
+    bool m_writing{false};
+    bool m_stop{false};
+    size_t m_written{0};
+    size_t m_dropped{0};  // snapshots replaced by a newer one before they were written
+    size_t m_failed{0};
+    std::thread m_thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cv.wait(lock, [this] { return m_pending.has_value() || m_stop; });
+            if (!m_pending) return;
+
+            Snapshot snapshot = std::move(*m_pending);
+            m_pending.reset();
+            m_writing = true;
+            lock.unlock();
+
+            bool written = false;
+            try {
+                written = write_atomically(m_file_path, [&](const std::string& path) { return m_write(snapshot, path); });
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to write checkpoint " << m_file_path << ": " << e.what() << std::endl;
+            }
+
+            lock.lock();
+            if (m_refresh && !m_spare) m_spare = std::move(snapshot);
+            m_writing = false;
+            (written ? m_written : m_failed)++;
+            m_cv.notify_all();
+        }
+    }
+
+   public:
+    AsyncCheckpointer(std::string file_path, CheckpointSchedule schedule, SnapshotFunction snapshot,
+                      WriteFunction write, RefreshFunction refresh = nullptr)
+        : m_file_path(std::move(file_path)),
+          m_schedule(schedule),
+          m_snapshot(std::move(snapshot)),
+          m_write(std::move(write)),
+          m_refresh(std::move(refresh)),
+          m_thread(&AsyncCheckpointer::run, this) {}
+
+    AsyncCheckpointer(const AsyncCheckpointer&) = delete;
+    AsyncCheckpointer& operator=(const AsyncCheckpointer&) = delete;
+
+    // Writes any queued snapshot, then stops the writer thread
+    ~AsyncCheckpointer() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    // Counts the schedule's episodes from `episode`, e.g. the solver's episode() after a resume
+    void resume_from(int episode) { m_last_episode = episode; }
+
+    // Episode callback for MDPSolver::set_episode_callback
+    void on_episode_end(int episode) {
+        bool episodes_due = m_schedule.episodes > 0 && episode - m_last_episode >= m_schedule.episodes;
+        bool interval_due = m_schedule.interval.count() > 0 && Clock::now() - m_last_time >= m_schedule.interval;
+        if (episodes_due || interval_due) {
+            m_last_episode = episode;
+            checkpoint();
+        }
+    }
+
+    // Snapshots now and queues the write
+    void checkpoint() {
+        m_last_time = Clock::now();
+        std::optional<Snapshot> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::swap(snapshot, m_spare);
+        }
+        if (snapshot) {
+            m_refresh(*snapshot);
+        } else {
+            snapshot.emplace(m_snapshot());
+        }
+        m_longest_pause = std::max(m_longest_pause, Clock::now() - m_last_time);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_pending) {
+                m_dropped++;
+                if (m_refresh && !m_spare) m_spare = std::move(m_pending);
+            }
+            m_pending = std::move(snapshot);
+        }
+        m_cv.notify_all();
+    }
+
+    // Blocks until every queued snapshot has been written
+    void flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_pending && !m_writing; });
+    }
+
+    size_t written() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_written;
+    }
+    size_t dropped() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_dropped;
+    }
+    size_t failed() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_failed;
+    }
+    // Longest time checkpoint() held up the training thread, in seconds
+    double longest_pause() const { return std::chrono::duration<double>(m_longest_pause).count(); }
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "StateArchive.h"
+#include "StateCodec.h"
+#include "ValueStrategy.h"
+
+enum class EvictionPolicy {
+    LeastRecentlyUpdated,  // the entry whose last set_q is oldest
+    LowestVisitCount,      // the entry with the fewest set_q calls, among EVICTION_SAMPLES random entries
+    Clock                  // second chance: the hand skips (and clears) entries read or written since its last pass
+};
+
+// Tabular Q with at most `capacity` (state, action) entries. Entries live in a fixed
+// slot array allocated up front; inserting into a full table evicts one entry chosen
+// by the eviction policy. Evicted entries read as 0 again, like never-seen ones.
+// LowestVisitCount samples with a generator seeded by the caller, and save_state
+// keeps the slot order, so a restored table evicts exactly what the original would.
+template <typename State, typename Action>
+class BoundedTabularValueStrategy : public ValueStrategy<State, Action> {
+   public:
+    struct Metrics {
+        size_t lookups = 0;  // Q reads, including those made by get_best_action
+        size_t hits = 0;     // Q reads that found an entry
+        size_t inserts = 0;
+        size_t evictions = 0;
+    };
+
+   protected:
+    using Key = std::pair<State, Action>;
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    static constexpr int EVICTION_SAMPLES = 16;
+
+    struct Slot {
+        Key key;
+        Return value;
+        uint32_t visits;
+        uint32_t prev, next;      // LeastRecentlyUpdated list, most recent first
+        mutable bool referenced;  // Clock
+    };
+
+    size_t m_capacity;
+    EvictionPolicy m_eviction;
+    std::vector<Slot> m_slots;
+    std::unordered_map<Key, uint32_t, StateActionPairHash<State, Action>> m_index;
+    uint32_t m_head{NONE}, m_tail{NONE};
+    uint32_t m_hand{0};
+    std::mt19937 m_generator;
+    MDP<State, Action>* m_mdp;
+    mutable Metrics m_metrics;
+
+    void unlink(uint32_t i) {
+        Slot& slot = m_slots[i];
+        (slot.prev != NONE ? m_slots[slot.prev].next : m_head) = slot.next;
+        (slot.next != NONE ? m_slots[slot.next].prev : m_tail) = slot.prev;
+    }
+
+    void push_front(uint32_t i) {
+        m_slots[i].prev = NONE;
+        m_slots[i].next = m_head;
+        if (m_head != NONE) m_slots[m_head].prev = i;
+        m_head = i;
+        if (m_tail == NONE) m_tail = i;
+    }
+
+    uint32_t victim() {
+        switch (m_eviction) {
+            case EvictionPolicy::LeastRecentlyUpdated:
+                return m_tail;
+            case EvictionPolicy::LowestVisitCount: {
+                std::uniform_int_distribution<uint32_t> dist(0, m_slots.size() - 1);
+                uint32_t best = dist(m_generator);
+                for (int i = 1; i < EVICTION_SAMPLES; i++) {
+                    uint32_t candidate = dist(m_generator);
+                    if (m_slots[candidate].visits < m_slots[best].visits) best = candidate;
+                }
+                return best;
+            }
+            case EvictionPolicy::Clock:
+                while (m_slots[m_hand].referenced) {
+                    m_slots[m_hand].referenced = false;
+                    m_hand = (m_hand + 1) % m_slots.size();
+                }
+                return m_hand;
+        }
+        return 0;
+    }
+
+    uint32_t insert(const Key& key) {
+        m_metrics.inserts++;
+        uint32_t i;
+        if (m_slots.size() < m_capacity) {
+            i = m_slots.size();
+            m_slots.push_back({key, 0, 0, NONE, NONE, false});
+        } else {
+            i = victim();
+            m_metrics.evictions++;
+            m_index.erase(m_slots[i].key);
+            if (m_eviction == EvictionPolicy::LeastRecentlyUpdated) unlink(i);
+            m_slots[i] = {key, 0, 0, NONE, NONE, false};
+        }
+        if (m_eviction == EvictionPolicy::LeastRecentlyUpdated) push_front(i);
+        m_index.emplace(key, i);
+        return i;
+    }
+
+   public:
+    BoundedTabularValueStrategy(size_t capacity, EvictionPolicy eviction, uint32_t seed)
+        : m_capacity(capacity), m_eviction(eviction), m_generator(seed), m_mdp(nullptr) {
+        if (capacity == 0 || capacity >= NONE) {
+            throw std::invalid_argument("Capacity must be between 1 and 2^32 - 2 entries");
+        }
+        m_slots.reserve(capacity);
+        m_index.reserve(capacity);
+    }
+
+    void initialize(MDP<State, Action>* mdp) override { m_mdp = mdp; }
+
+    std::tuple<Action, Return> get_best_action(const State& s) override {
+        if (!m_mdp) {
+            throw std::logic_error("BoundedTabularValueStrategy not initialized with an MDP");
+        }
+
+        Return max_return = std::numeric_limits<Return>::lowest();
+        Action maximizing_action;
+
+        for (const Action& a : m_mdp->actions(s)) {
+            Return candidate_return = Q(s, a);
+            if (candidate_return > max_return) {
+                max_return = candidate_return;
+                maximizing_action = a;
+            }
+        }
+
+        return {maximizing_action, max_return};
+    }
+
+    Return Q(const State& s, const Action& a) const {
+        m_metrics.lookups++;
+        auto it = m_index.find({s, a});
+        if (it == m_index.end()) return 0;
+
+        m_metrics.hits++;
+        const Slot& slot = m_slots[it->second];
+        slot.referenced = true;
+        return slot.value;
+    }
+
+    void set_q(const State& s, const Action& a, Return value) {
+        Key key{s, a};
+        auto it = m_index.find(key);
+        uint32_t i = it != m_index.end() ? it->second : insert(key);
+
+        Slot& slot = m_slots[i];
+        slot.value = value;
+        slot.visits++;
+        slot.referenced = true;
+        if (m_eviction == EvictionPolicy::LeastRecentlyUpdated && m_head != i) {
+            unlink(i);
+            push_front(i);
+        }
+    }
+
+    size_t size() const { return m_slots.size(); }
+    size_t capacity() const { return m_capacity; }
+    const Metrics& metrics() const { return m_metrics; }
+    double hit_rate() const { return m_metrics.lookups ? static_cast<double>(m_metrics.hits) / m_metrics.lookups : 0; }
+
+    void save_state(StateWriter& writer) const {
+        using KeyCodec = FlatCodec<Key>;
+        writer.write_string(KeyCodec::signature());
+        writer.write<uint64_t>(m_capacity);
+        writer.write(m_eviction);
+        writer.write<uint64_t>(m_slots.size());
+        int32_t words[KeyCodec::WIDTH];
+        for (const Slot& slot : m_slots) {
+            KeyCodec::encode(slot.key, words);
+            for (int32_t word : words) writer.write(word);
+            writer.write(slot.value);
+            writer.write(slot.visits);
+            writer.write(slot.prev);
+            writer.write(slot.next);
+            writer.write(slot.referenced);
+        }
+        writer.write(m_head);
+        writer.write(m_tail);
+        writer.write(m_hand);
+        writer.write_engine(m_generator);
+        writer.write(m_metrics);
+    }
+
+    // Requires a table constructed with the same capacity and eviction policy
+    void load_state(StateReader& reader) {
+        using KeyCodec = FlatCodec<Key>;
+        if (reader.read_string() != KeyCodec::signature()) {
+            throw std::runtime_error("state or action type differs from the saved table");
+        }
+        if (reader.read<uint64_t>() != m_capacity || reader.read<EvictionPolicy>() != m_eviction) {
+            throw std::runtime_error("capacity or eviction policy differs from the saved table");
+        }
+        size_t size = reader.read<uint64_t>();
+        if (size > m_capacity) throw std::runtime_error("saved table holds more entries than its capacity");
+
+        m_slots.clear();
+        m_index.clear();
+        int32_t words[KeyCodec::WIDTH];
+        for (size_t i = 0; i < size; i++) {
+            for (int32_t& word : words) word = reader.read<int32_t>();
+            Slot slot{KeyCodec::decode(words), 0, 0, NONE, NONE, false};
+            slot.value = reader.read<Return>();
+            slot.visits = reader.read<uint32_t>();
+            slot.prev = reader.read<uint32_t>();
+            slot.next = reader.read<uint32_t>();
+            slot.referenced = reader.read<bool>();
+            if ((slot.prev != NONE && slot.prev >= size) || (slot.next != NONE && slot.next >= size)) {
+                throw std::runtime_error("saved table links to a slot that does not exist");
+            }
+            m_index.emplace(slot.key, i);
+            m_slots.push_back(slot);
+        }
+        m_head = reader.read<uint32_t>();
+        m_tail = reader.read<uint32_t>();
+        m_hand = reader.read<uint32_t>();
+        if ((m_head != NONE && m_head >= size) || (m_tail != NONE && m_tail >= size) || (size && m_hand >= size)) {
+            throw std::runtime_error("saved table links to a slot that does not exist");
+        }
+        reader.read_engine(m_generator);
+        m_metrics = reader.read<Metrics>();
+    }
+
+    void report(std::ostream& out) const {
+        out << "Q table: " << size() << "/" << capacity() << " entries, " << m_metrics.evictions << " evictions, hit rate "
+            << 100.0 * hit_rate() << "%" << std::endl;
+    }
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MDP.h"
+#include "MappedFile.h"
+#include "Policy.h"
+#include "StateCodec.h"
+#include "StateIndexer.h"
+
+// A trained policy frozen into a dense array of action ids indexed by state id.
+// compile() takes the greedy action of every non-terminal state once; sample()
+// is then an index lookup plus one array load. save() writes a compact binary
+// file that load() maps into memory; the indexer and the action ids are used in
+// place, so loading does not decode or rehash the states.
+//
+// File layout (native endianness): header, action table (FlatCodec words, padded
+// to 8 bytes), indexer image (Indexer::save), one uint32 action id per state.
+template <typename State, typename Action, typename Indexer = StateIndexer<State>>
+class CompiledPolicy : public Policy<State, Action> {
+   private:
+    static constexpr char MAGIC[4] = {'R', 'L', 'C', 'P'};
+    static constexpr uint32_t VERSION = 3;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t state_width;
+        uint32_t action_width;
+        uint64_t state_count;
+        uint64_t action_count;
+        uint64_t indexer_bytes;
+    };
+
+    Indexer m_indexer;
+    std::vector<Action> m_actions;    // action table
+    std::vector<uint32_t> m_owned;    // action ids when compiled in memory
+    const uint32_t* m_action_ids = nullptr;  // m_owned or the mapped file
+    MappedFile m_file;
+
+    uint32_t action_id(const Action& a) {
+        auto it = std::find(m_actions.begin(), m_actions.end(), a);
+        if (it != m_actions.end()) return it - m_actions.begin();
+        m_actions.push_back(a);
+        return m_actions.size() - 1;
+    }
+
+    void freeze(const std::vector<std::pair<State, Action>>& decisions) {
+        std::vector<State> states;
+        states.reserve(decisions.size());
+        for (const auto& [s, a] : decisions) states.push_back(s);
+        m_indexer.build(states);
+
+        m_actions.clear();
+        m_owned.assign(m_indexer.size(), 0);
+        for (const auto& [s, a] : decisions) m_owned[m_indexer.index(s)] = action_id(a);
+        m_file = MappedFile();
+        m_action_ids = m_owned.data();
+    }
+
+   public:
+    CompiledPolicy() : Policy<State, Action>() {}
+
+    // Unknown states fall back to this strategy's greedy action instead of throwing
+    CompiledPolicy(ValueStrategy<State, Action>* fallback) : Policy<State, Action>(fallback) {}
+
+    CompiledPolicy(const CompiledPolicy&) = delete;
+    CompiledPolicy& operator=(const CompiledPolicy&) = delete;
+
+    // Freezes the greedy action of `policy` in every non-terminal state of `mdp`
+    void compile(MDP<State, Action>& mdp, Policy<State, Action>& policy) {
+        std::vector<std::pair<State, Action>> decisions;
+        for (const State& s : mdp.states()) {
+            if (!mdp.is_terminal(s)) decisions.emplace_back(s, std::get<0>(policy.greedy_action(s)));
+        }
+        freeze(decisions);
+    }
+
+    // Freezes an explicit state -> action map, e.g. the result of Policy::optimal()
+    void compile(const std::unordered_map<State, Action, StateHash<State>>& policy_map) {
+        freeze({policy_map.begin(), policy_map.end()});
+    }
+
+    Action sample(const State& s) override {
+        size_t id = m_indexer.index(s);
+        if (id == Indexer::NOT_FOUND) {
+            if (this->m_value_strategy) return std::get<0>(this->greedy_action(s));
+            throw std::out_of_range("State not found in compiled policy");
+        }
+        uint32_t action = m_action_ids[id];
+        if (action >= m_actions.size()) throw std::out_of_range("Compiled policy has a damaged action id");
+        return m_actions[action];
+    }
+
+    size_t size() const { return m_indexer.size(); }
+    State state(size_t id) const { return m_indexer.state(id); }
+
+    bool save(const std::string& file_path) const {
+        using StateCodec = FlatCodec<State>;
+        using ActionCodec = FlatCodec<Action>;
+
+        std::ofstream file(output_dir + file_path, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file for writing compiled policy: " << file_path << std::endl;
+            return false;
+        }
+
+        std::ostringstream indexer;
+        m_indexer.save(indexer);
+        std::string image = indexer.str();
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.state_width = StateCodec::WIDTH;
+        header.action_width = ActionCodec::WIDTH;
+        header.state_count = size();
+        header.action_count = m_actions.size();
+        header.indexer_bytes = image.size();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<int32_t> words((ActionCodec::WIDTH * m_actions.size() + 1) / 2 * 2, 0);
+        for (size_t i = 0; i < m_actions.size(); i++) ActionCodec::encode(m_actions[i], &words[i * ActionCodec::WIDTH]);
+        file.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(int32_t));
+
+        file.write(image.data(), image.size());
+        file.write(reinterpret_cast<const char*>(m_action_ids), size() * sizeof(uint32_t));
+
+        if (!file) {
+            std::cerr << "Failed to write compiled policy: " << file_path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool load(const std::string& file_path) {
+        using StateCodec = FlatCodec<State>;
+        using ActionCodec = FlatCodec<Action>;
+
+        try {
+            MappedFile file(output_dir + file_path);
+
+            Header header;
+            if (file.size() < sizeof(header)) throw std::runtime_error("file too small");
+            std::memcpy(&header, file.data(), sizeof(header));
+            if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+                throw std::runtime_error("not a compiled policy file of version " + std::to_string(VERSION));
+            }
+            if (header.state_width != StateCodec::WIDTH || header.action_width != ActionCodec::WIDTH) {
+                throw std::runtime_error("state or action type does not match the file");
+            }
+
+            // Bound every count by the file size before computing offsets from it
+            size_t body = file.size() - sizeof(header);
+            if (header.action_count > body || header.state_count > body || header.indexer_bytes > body ||
+                header.indexer_bytes % 8 != 0) {
+                throw std::runtime_error("truncated or damaged file");
+            }
+            size_t action_words = (header.action_count * ActionCodec::WIDTH + 1) / 2 * 2;
+            size_t expected =
+                sizeof(header) + action_words * sizeof(int32_t) + header.indexer_bytes + header.state_count * sizeof(uint32_t);
+            if (file.size() != expected) throw std::runtime_error("truncated or oversized file");
+
+            const auto* words = reinterpret_cast<const int32_t*>(file.data() + sizeof(header));
+            std::vector<Action> actions(header.action_count);
+            for (size_t i = 0; i < actions.size(); i++) actions[i] = ActionCodec::decode(words + i * ActionCodec::WIDTH);
+
+            const char* image = reinterpret_cast<const char*>(words + action_words);
+            Indexer indexer;
+            indexer.attach(image, header.indexer_bytes);
+            if (indexer.size() != header.state_count) throw std::runtime_error("indexer does not match the state count");
+            const auto* action_ids = reinterpret_cast<const uint32_t*>(image + header.indexer_bytes);
+
+            m_indexer = std::move(indexer);
+            m_actions = std::move(actions);
+            m_owned.clear();
+            m_action_ids = action_ids;
+            m_file = std::move(file);
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to load compiled policy: " << e.what() << std::endl;
+            return false;
+        }
+    }
+};
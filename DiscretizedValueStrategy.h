@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "ValueStrategy.h"
+
+// Tabular Q over a bounded key space: `Discretizer` maps every state to a key in
+// [0, size()), and Q is a flat array of size() x |all_actions()| values allocated
+// once in initialize(). States that share a key share their Q values.
+//
+// Discretizer must provide `size_t size() const` and `size_t operator()(const State&) const`.
+template <typename State, typename Action, typename Discretizer>
+class DiscretizedValueStrategy : public ValueStrategy<State, Action> {
+   protected:
+    Discretizer m_discretizer;
+    MDP<State, Action>* m_mdp;
+    std::vector<Action> m_actions;
+    std::unordered_map<Action, size_t, StateHash<Action>> m_action_ids;
+    std::vector<Return> m_Q;
+    std::vector<bool> m_visited;  // keys that have been updated at least once
+    size_t m_visited_count{0};
+    size_t m_lookups{0};
+    size_t m_hits{0};
+
+    size_t cell(const State& s, const Action& a) const {
+        auto it = m_action_ids.find(a);
+        if (it == m_action_ids.end()) {
+            throw std::out_of_range("Action not in the MDP's action set");
+        }
+        return m_discretizer(s) * m_actions.size() + it->second;
+    }
+
+   public:
+    explicit DiscretizedValueStrategy(const Discretizer& discretizer) : m_discretizer(discretizer), m_mdp(nullptr) {}
+
+    // Requires the MDP's actions, so call it after the MDP has been initialized
+    void initialize(MDP<State, Action>* mdp) override {
+        m_mdp = mdp;
+        m_actions = mdp->all_actions();
+        m_action_ids.clear();
+        for (size_t i = 0; i < m_actions.size(); i++) m_action_ids.emplace(m_actions[i], i);
+
+        m_Q.assign(m_discretizer.size() * m_actions.size(), 0);
+        m_visited.assign(m_discretizer.size(), false);
+        m_visited_count = 0;
+        m_lookups = 0;
+        m_hits = 0;
+    }
+
+    std::tuple<Action, Return> get_best_action(const State& s) override {
+        if (!m_mdp) {
+            throw std::logic_error("DiscretizedValueStrategy not initialized with an MDP");
+        }
+
+        size_t key = m_discretizer(s);
+        m_lookups++;
+        if (m_visited[key]) m_hits++;
+
+        const auto* mask = m_mdp->action_mask(s);
+        const Return* q = &m_Q[key * m_actions.size()];
+        Return max_return = std::numeric_limits<Return>::lowest();
+        Action maximizing_action;
+
+        for (size_t i = 0; i < m_actions.size(); i++) {
+            if (mask ? !(*mask)[i] : !m_mdp->is_valid(s, m_actions[i])) continue;
+            if (q[i] > max_return) {
+                max_return = q[i];
+                maximizing_action = m_actions[i];
+            }
+        }
+
+        return {maximizing_action, max_return};
+    }
+
+    Return Q(const State& s, const Action& a) const { return m_Q[cell(s, a)]; }
+
+    void set_q(const State& s, const Action& a, Return value) {
+        mark_visited(m_discretizer(s));
+        m_Q[cell(s, a)] = value;
+    }
+
+    const Discretizer& discretizer() const { return m_discretizer; }
+    const std::vector<Action>& actions() const { return m_actions; }
+    // Q values of `key`, one per action in actions() order
+    Return* values(size_t key) { return &m_Q[key * m_actions.size()]; }
+    const Return* values(size_t key) const { return &m_Q[key * m_actions.size()]; }
+    bool visited(size_t key) const { return m_visited[key]; }
+    void mark_visited(size_t key) {
+        if (!m_visited[key]) {
+            m_visited[key] = true;
+            m_visited_count++;
+        }
+    }
+
+    size_t table_size() const { return m_discretizer.size(); }
+    size_t visited_keys() const { return m_visited_count; }
+    // Fraction of greedy lookups that landed on a key updated before
+    double hit_rate() const { return m_lookups ? static_cast<double>(m_hits) / m_lookups : 0; }
+
+    void save_state(StateWriter& writer) const {
+        writer.write_vector(m_Q);
+        writer.write_vector(m_visited);
+        writer.write(m_visited_count);
+        writer.write(m_lookups);
+        writer.write(m_hits);
+    }
+
+    // Requires initialize() with the same discretization and action set as the saved table
+    void load_state(StateReader& reader) {
+        size_t expected = m_Q.size();
+        reader.read_vector(m_Q);
+        reader.read_vector(m_visited);
+        if (m_Q.size() != expected || m_visited.size() != table_size()) {
+            throw std::runtime_error("discretization or action set differs from the saved table");
+        }
+        m_visited_count = reader.read<size_t>();
+        m_lookups = reader.read<size_t>();
+        m_hits = reader.read<size_t>();
+    }
+
+    void report(std::ostream& out) const {
+        out << "Q table: " << table_size() << " keys x " << m_actions.size() << " actions ("
+            << m_Q.size() * sizeof(Return) / 1024 << " KiB), " << visited_keys() << " keys visited ("
+            << 100.0 * visited_keys() / table_size() << "%), greedy hit rate " << 100.0 * hit_rate() << "%"
+            << std::endl;
+    }
+};
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <limits>
 
 #include "FunctionApproximator.h"
 #include "GPI.h"
 #include "Policy.h"
+#include "StateArchive.h"
 #include "m_utils.h"
 
 template <typename State, typename Action>
@@ -26,9 +28,7 @@ class FA_TD : public GPI<State, Action> {
     };
 
     void td_main() {
-        int i = 0;
-        do {  // episode loop
-            i++;
+        while (this->m_episode < this->m_policy_threshold) {  // episode loop
             State s = this->m_mdp->reset();
             Action a = this->m_policy->sample(s);
             do {  // step loop
@@ -41,14 +41,88 @@ class FA_TD : public GPI<State, Action> {
                 } else {
                     Action a_prime = this->m_policy->sample(s_prime);
                     double q_next = m_value_strategy->get_approximator()->predict(s_prime, a_prime);
-                    double error = (r + this->m_discount_rate * q_next) - q_current;
+                    double discount = std::pow(this->m_discount_rate, this->m_mdp->step_duration());
+                    double error = (r + discount * q_next) - q_current;
                     m_value_strategy->get_approximator()->update(s, a, error, this->step_size);
                     a = a_prime;
                 }
 
                 s = s_prime;
-            } while (!this->m_mdp->is_terminal(s));
-        } while (i < this->m_policy_threshold);
+            } while (!this->m_mdp->is_terminal(s) && !this->m_mdp->truncated());
+            this->end_episode(++this->m_episode);
+        }
+    }
+
+    void policy_iteration() override { td_main(); }
+
+    void save_state(StateWriter& writer) const {
+        writer.write(this->m_episode);
+        this->m_policy->save_state(writer);
+        m_value_strategy->save_state(writer);
+    }
+
+    void load_state(StateReader& reader) {
+        this->m_episode = reader.read<int>();
+        this->m_policy->load_state(reader);
+        m_value_strategy->load_state(reader);
+    }
+};
+
+// FA_TD with the concrete environment, policy and approximator types known at compile
+// time, so the step loop binds every call statically (see StaticTD). Pair it with
+// StaticLinearFunctionApproximator: LinearFunctionApproximator allocates a feature
+// vector through a std::function on every call, which costs more than the dispatch.
+template <typename Env, typename PolicyType,
+          typename ApproximatorType = LinearFunctionApproximator<typename Env::StateType, typename Env::ActionType>>
+class StaticFA_TD : public FA_TD<typename Env::StateType, typename Env::ActionType> {
+   public:
+    using State = typename Env::StateType;
+    using Action = typename Env::ActionType;
+
+   protected:
+    Env* m_env;
+    PolicyType* m_typed_policy;
+    ApproximatorType* m_approximator;
+
+    Action sample(const State& s) {
+        return m_typed_policy->sample_static(*m_env, s, [this](const State& state) {
+            return std::get<0>(this->m_value_strategy->get_best_action_static(*m_env, *m_approximator, state));
+        });
+    }
+
+   public:
+    StaticFA_TD(Env* env, PolicyType* policy, ApproximationValueStrategy<State, Action>* value_strategy,
+                ApproximatorType* approximator, const double discount_rate, const long double policy_threshold,
+                const double step_size)
+        : FA_TD<State, Action>(env, policy, value_strategy, discount_rate, policy_threshold, step_size),
+          m_env(env),
+          m_typed_policy(policy),
+          m_approximator(approximator) {}
+
+    void td_main() {
+        ApproximatorType& approximator = *m_approximator;
+        while (this->m_episode < this->m_policy_threshold) {  // episode loop
+            State s = m_env->Env::reset();
+            Action a = sample(s);
+            do {  // step loop
+                auto [s_prime, r] = m_env->Env::step(s, a);
+                double q_current = approximator.ApproximatorType::predict(s, a);
+
+                if (m_env->Env::is_terminal(s_prime)) {
+                    approximator.ApproximatorType::update(s, a, r - q_current, this->step_size);
+                } else {
+                    Action a_prime = sample(s_prime);
+                    double q_next = approximator.ApproximatorType::predict(s_prime, a_prime);
+                    double discount = std::pow(this->m_discount_rate, m_env->Env::step_duration());
+                    double error = (r + discount * q_next) - q_current;
+                    approximator.ApproximatorType::update(s, a, error, this->step_size);
+                    a = a_prime;
+                }
+
+                s = s_prime;
+            } while (!m_env->Env::is_terminal(s) && !m_env->Env::truncated());
+            this->end_episode(++this->m_episode);
+        }
     }
 
     void policy_iteration() override { td_main(); }
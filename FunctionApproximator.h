@@ -3,6 +3,7 @@
 #include <functional>
 #include <random>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 template <typename State, typename Action>
@@ -61,3 +62,61 @@ class LinearFunctionApproximator : public FunctionApproximator<State, Action> {
         weights = new_weights;
     }
 };
+
+// LinearFunctionApproximator with the feature extractor's type known at compile time and
+// sparse features. `Features` appends the nonzero features of (s, a) as (index, value)
+// pairs: void operator()(const State&, const Action&, std::vector<std::pair<size_t, double>>&) const.
+// predict() and update() touch only those entries and reuse one buffer, so calls must
+// come from one thread; StaticFA_TD can inline them.
+template <typename State, typename Action, typename Features>
+class StaticLinearFunctionApproximator : public FunctionApproximator<State, Action> {
+   private:
+    std::vector<double> weights;
+    Features feature_extractor;
+    mutable std::vector<std::pair<size_t, double>> active;
+
+    const std::vector<std::pair<size_t, double>>& extract(const State& s, const Action& a) const {
+        active.clear();
+        feature_extractor(s, a, active);
+        return active;
+    }
+
+   public:
+    StaticLinearFunctionApproximator(int feature_dim, Features fe = Features())
+        : weights(feature_dim, 0.0), feature_extractor(std::move(fe)) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_real_distribution<> dis(-0.1, 0.1);
+
+        for (size_t i = 0; i < weights.size(); ++i) {
+            weights[i] = dis(gen);
+        }
+    }
+
+    double predict(const State& s, const Action& a) const final {
+        double value = 0.0;
+        for (const auto& [i, x] : extract(s, a)) value += weights[i] * x;
+        return value;
+    }
+
+    std::vector<double> gradient(const State& s, const Action& a) const final {
+        std::vector<std::pair<size_t, double>> nonzero;
+        feature_extractor(s, a, nonzero);
+        std::vector<double> x(weights.size(), 0.0);
+        for (const auto& [i, value] : nonzero) x[i] += value;
+        return x;
+    }
+
+    void update(const State& s, const Action& a, double error, double step_size) final {
+        for (const auto& [i, x] : extract(s, a)) weights[i] += step_size * error * x;
+    }
+
+    const std::vector<double>& get_weights() const final { return weights; }
+
+    void set_weights(const std::vector<double>& new_weights) final {
+        if (weights.size() != new_weights.size()) {
+            throw std::invalid_argument("Weight vector size mismatch");
+        }
+        weights = new_weights;
+    }
+};
@@ -7,13 +7,18 @@ class GPI : public MDPSolver<State, Action> {
    protected:
     double m_discount_rate;
     long double m_policy_threshold;
+    int m_episode{0};  // episodes completed, kept across runs so a restored solver continues its count
 
     virtual void policy_evaluation(){};
     virtual bool policy_improvement() { return false; };
 
    public:
     GPI(MDP<State, Action>* mdp_core, Policy<State, Action>* policy, const double discount_rate, const long double policy_threshold)
-        : MDPSolver<State, Action>(mdp_core, policy), m_discount_rate(discount_rate), m_policy_threshold(policy_threshold) {}
+        : MDPSolver<State, Action>(mdp_core, policy), m_discount_rate(discount_rate), m_policy_threshold(policy_threshold) {
+        mdp_core->set_discount_rate(discount_rate);
+    }
+
+    int episode() const { return m_episode; }
 
     virtual void policy_iteration() {
         bool policy_stable;
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+// Keeps the latest version of an object loaded from a file that is replaced while
+// the program runs, e.g. weights or a compiled policy pushed to a deployed agent.
+// A background thread polls the file's modification time and size; when they
+// change, load(path) builds a new object off the serving thread and publishes it
+// with an atomic pointer swap. A load that fails (e.g. a half-written file) keeps
+// the current object; the file is tried again once it changes.
+//
+// Readers never wait: get() returns the current object as a shared_ptr, which the
+// reader holds for as long as it uses it (e.g. one step), so a swap never changes
+// an object in use. The old object is freed when its last reader releases it.
+// Objects are shared between threads and must only be read.
+template <typename T>
+class HotReloader {
+   public:
+    // Returns nullptr if the file could not be loaded
+    using LoadFunction = std::function<std::shared_ptr<T>(const std::string&)>;
+
+   private:
+    struct FileVersion {
+        int64_t mtime_ns = -1;
+        int64_t size = -1;
+
+        bool operator==(const FileVersion& o) const { return mtime_ns == o.mtime_ns && size == o.size; }
+    };
+
+    std::string m_file_path;
+    LoadFunction m_load;
+    std::chrono::milliseconds m_poll_interval;
+
+    std::shared_ptr<T> m_current;  // only accessed through std::atomic_load/atomic_store
+    std::atomic<uint64_t> m_version{0};
+    FileVersion m_loaded;
+    FileVersion m_failed;  // last version that failed to load, not retried until the file changes again
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop{false};
+    std::thread m_thread;
+
+    FileVersion stat_file() const {
+        struct stat info;
+        if (::stat(m_file_path.c_str(), &info) != 0) return {};
+        return {static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec,
+                static_cast<int64_t>(info.st_size)};
+    }
+
+    void poll() {
+        FileVersion file = stat_file();
+        if (file.size < 0 || file == m_loaded || file == m_failed) return;
+
+        std::shared_ptr<T> loaded = m_load(m_file_path);
+        if (!loaded) {
+            std::cerr << "Keeping the current version of " << m_file_path << std::endl;
+            m_failed = file;
+            return;
+        }
+        // A writer that finished while we were loading gets picked up on the next poll
+        m_loaded = file;
+        std::atomic_store(&m_current, std::move(loaded));
+        m_version.fetch_add(1, std::memory_order_release);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_cv.wait_for(lock, m_poll_interval, [this] { return m_stop; })) {
+            lock.unlock();
+            poll();
+            lock.lock();
+        }
+    }
+
+   public:
+    // Loads the file once before returning (get() is nullptr if that fails), then watches it
+    HotReloader(std::string file_path, LoadFunction load,
+                std::chrono::milliseconds poll_interval = std::chrono::milliseconds(500))
+        : m_file_path(std::move(file_path)), m_load(std::move(load)), m_poll_interval(poll_interval) {
+        poll();
+        m_thread = std::thread(&HotReloader::run, this);
+    }
+
+    HotReloader(const HotReloader&) = delete;
+    HotReloader& operator=(const HotReloader&) = delete;
+
+    ~HotReloader() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    std::shared_ptr<T> get() const { return std::atomic_load(&m_current); }
+
+    // Incremented on every swap; compare against a cached value to skip get() when nothing changed
+    uint64_t version() const { return m_version.load(std::memory_order_acquire); }
+
+    // Refreshes a reader's cached object if a newer one was published since `seen`
+    bool refresh(std::shared_ptr<T>& object, uint64_t& seen) const {
+        uint64_t current = version();
+        if (current == seen) return false;
+        seen = current;
+        object = get();
+        return true;
+    }
+};
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Streaming JSON output: values go straight into a fixed buffer that is flushed
+// to the file descriptor when full, so writing a table needs no DOM and constant
+// memory. Output is indented like nlohmann's dump(4). Pairs, tuples and vectors
+// are written as arrays, non-finite numbers as null.
+class JsonWriter {
+   private:
+    static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+    int m_fd;
+    std::vector<char> m_buffer;
+    size_t m_used{0};
+    // One entry per open object/array: whether it has members yet
+    std::vector<bool> m_has_members;
+    bool m_after_key{false};
+
+    void put(char c) {
+        if (m_used == m_buffer.size()) flush();
+        m_buffer[m_used++] = c;
+    }
+
+    void put(const char* data, size_t size) {
+        if (m_used + size > m_buffer.size()) flush();
+        if (size > m_buffer.size()) {
+            write_all(data, size);
+            return;
+        }
+        std::copy(data, data + size, m_buffer.data() + m_used);
+        m_used += size;
+    }
+
+    void put(const std::string& s) { put(s.data(), s.size()); }
+
+    void write_all(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(m_fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Failed to write JSON output");
+            }
+            data += written;
+            size -= written;
+        }
+    }
+
+    void newline() {
+        put('\n');
+        for (size_t i = 0; i < m_has_members.size(); i++) put("    ", 4);
+    }
+
+    // Separator and indentation before a value or key
+    void next() {
+        if (m_after_key) {
+            m_after_key = false;
+            return;
+        }
+        if (m_has_members.empty()) return;
+        if (m_has_members.back()) put(',');
+        m_has_members.back() = true;
+        newline();
+    }
+
+    void open_scope(char bracket) {
+        next();
+        put(bracket);
+        m_has_members.push_back(false);
+    }
+
+    void close_scope(char bracket) {
+        bool had_members = m_has_members.back();
+        m_has_members.pop_back();
+        if (had_members) newline();
+        put(bracket);
+    }
+
+    void string_literal(const std::string& s) {
+        put('"');
+        for (char c : s) {
+            switch (c) {
+                case '"': put("\\\"", 2); break;
+                case '\\': put("\\\\", 2); break;
+                case '\n': put("\\n", 2); break;
+                case '\t': put("\\t", 2); break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char escaped[7];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        put(escaped, 6);
+                    } else {
+                        put(c);
+                    }
+            }
+        }
+        put('"');
+    }
+
+    template <typename Tuple, size_t... Is>
+    void tuple_elements(const Tuple& t, std::index_sequence<Is...>) {
+        (value(std::get<Is>(t)), ...);
+    }
+
+   public:
+    explicit JsonWriter(const std::string& file_path) : m_buffer(BUFFER_SIZE) {
+        m_fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) {
+            throw std::runtime_error("Failed to open file for writing JSON.");
+        }
+    }
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    ~JsonWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    void flush() {
+        write_all(m_buffer.data(), m_used);
+        m_used = 0;
+    }
+
+    // Flushes and closes the file; throws if anything could not be written
+    void close() {
+        if (m_fd < 0) return;
+        bool written = true;
+        try {
+            flush();
+        } catch (const std::exception&) {
+            written = false;
+        }
+        written = ::close(m_fd) == 0 && written;
+        m_fd = -1;
+        if (!written) throw std::runtime_error("Failed to write JSON output");
+    }
+
+    JsonWriter& begin_object() {
+        open_scope('{');
+        return *this;
+    }
+    JsonWriter& end_object() {
+        close_scope('}');
+        return *this;
+    }
+    JsonWriter& begin_array() {
+        open_scope('[');
+        return *this;
+    }
+    JsonWriter& end_array() {
+        close_scope(']');
+        return *this;
+    }
+
+    JsonWriter& key(const std::string& name) {
+        next();
+        string_literal(name);
+        put(": ", 2);
+        m_after_key = true;
+        return *this;
+    }
+
+    template <typename T>
+    JsonWriter& value(const T& v) {
+        if constexpr (std::is_same_v<T, bool>) {
+            next();
+            v ? put("true", 4) : put("false", 5);
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            next();
+            if constexpr (std::is_floating_point_v<T>) {
+                if (!std::isfinite(v)) {
+                    put("null", 4);
+                    return *this;
+                }
+            }
+            char digits[32];
+            auto result = std::to_chars(digits, digits + sizeof(digits), v);
+            put(digits, result.ptr - digits);
+            // Keep floats recognizable as floats, like nlohmann does
+            if constexpr (std::is_floating_point_v<T>) {
+                if (std::find_if(digits, result.ptr, [](char c) { return c == '.' || c == 'e'; }) == result.ptr) {
+                    put(".0", 2);
+                }
+            }
+        } else if constexpr (std::is_convertible_v<T, std::string>) {
+            next();
+            string_literal(v);
+        } else {
+            begin_array();
+            tuple_elements(v, std::make_index_sequence<std::tuple_size<T>::value>{});
+            end_array();
+        }
+        return *this;
+    }
+
+    template <typename T>
+    JsonWriter& value(const std::vector<T>& v) {
+        begin_array();
+        for (const auto& element : v) value(static_cast<const T&>(element));  // also unwraps vector<bool> references
+        end_array();
+        return *this;
+    }
+
+    template <typename T>
+    JsonWriter& member(const std::string& name, const T& v) {
+        key(name);
+        return value(v);
+    }
+};
+
+// Base for SAX handlers passed to nlohmann::json::sax_parse. Accepts every event;
+// subclasses override the ones they need and read the document incrementally.
+// depth() is the number of enclosing objects and arrays.
+class JsonSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+   protected:
+    size_t m_depth{0};
+
+   public:
+    size_t depth() const { return m_depth; }
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t) override { return true; }
+    bool number_unsigned(number_unsigned_t) override { return true; }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool string(string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+    bool start_object(std::size_t) override {
+        m_depth++;
+        return true;
+    }
+    bool key(string_t&) override { return true; }
+    bool end_object() override {
+        m_depth--;
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        m_depth++;
+        return true;
+    }
+    bool end_array() override {
+        m_depth--;
+        return true;
+    }
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& e) override {
+        throw std::runtime_error("JSON parse error at byte " + std::to_string(position) + ": " + e.what());
+    }
+};
+
+// Calls on_entry(key, value) for each number-valued member of a top-level object {"key": value, ...}
+template <typename OnEntry>
+class JsonObjectReader : public JsonSaxHandler {
+   private:
+    OnEntry m_on_entry;
+    std::string m_key;
+
+    bool entry(double value) {
+        if (m_depth == 1) m_on_entry(m_key, value);
+        return true;
+    }
+
+   public:
+    explicit JsonObjectReader(OnEntry on_entry) : m_on_entry(std::move(on_entry)) {}
+
+    bool key(string_t& k) override {
+        if (m_depth == 1) m_key = std::move(k);
+        return true;
+    }
+    bool number_integer(number_integer_t v) override { return entry(v); }
+    bool number_unsigned(number_unsigned_t v) override { return entry(v); }
+    bool number_float(number_float_t v, const string_t&) override { return entry(v); }
+};
+
+// Runs `handler` over the JSON file at file_path without building a DOM
+template <typename Handler>
+void parse_json_file(const std::string& file_path, Handler& handler) {
+    std::FILE* input = std::fopen(file_path.c_str(), "rb");
+    if (!input) {
+        throw std::runtime_error("Failed to open " + file_path);
+    }
+    try {
+        nlohmann::json::sax_parse(input, &handler);
+    } catch (...) {
+        std::fclose(input);
+        throw;
+    }
+    std::fclose(input);
+}
@@ -4,12 +4,14 @@
 
 #include "GPI.h"
 #include "Policy.h"
+#include "StateActionTable.h"
+#include "StateArchive.h"
 #include "m_utils.h"
 
 template <typename State, typename Action, typename ValueStrategyType = TabularValueStrategy<State, Action>>
 class MC_FV : public GPI<State, Action> {
    protected:
-    std::unordered_map<std::pair<State, Action>, int, StateActionPairHash<State, Action>> N;
+    StateActionTable<State, Action, int> N;  // visit counts, dense for indexed states
     std::unordered_map<State, std::vector<Return>, StateHash<State>> m_returns;
     ValueStrategyType* m_value_strategy;
     Return avg_returns(const State& s) {
@@ -37,12 +39,11 @@ class MC_FV : public GPI<State, Action> {
           const double discount_rate, const double number_of_episodes)
         : GPI<State, Action>(mdp_core, policy, discount_rate, number_of_episodes), m_value_strategy(value_strategy) {
         policy->initialize(mdp_core, value_strategy);
+        N.initialize(*mdp_core);
     };
 
     void mc_main(const std::function<void(const State&, const Action&, Return)>& update_fn) {
-        int episode_n = 0;
-        do {
-            episode_n++;
+        while (this->m_episode < this->m_policy_threshold) {
             auto episode = this->generate_episode();
 
             std::unordered_map<std::pair<State, Action>, int, StateActionPairHash<State, Action>>
@@ -63,7 +64,8 @@ class MC_FV : public GPI<State, Action> {
                     update_fn(s, a, G);
                 }
             }
-        } while (episode_n < this->m_policy_threshold);
+            this->end_episode(++this->m_episode);
+        }
     }
 
     void policy_iteration() override {
@@ -80,4 +82,20 @@ class MC_FV : public GPI<State, Action> {
             m_value_strategy->set_v(s, avg_returns(s));
         });
     }
+
+    void save_state(StateWriter& writer) const {
+        writer.write(this->m_episode);
+        N.save_state(writer);
+        writer.write_map(m_returns);
+        this->m_policy->save_state(writer);
+        m_value_strategy->save_state(writer);
+    }
+
+    void load_state(StateReader& reader) {
+        this->m_episode = reader.read<int>();
+        N.load_state(reader);
+        reader.read_map(m_returns);
+        this->m_policy->load_state(reader);
+        m_value_strategy->load_state(reader);
+    }
 };
\ No newline at end of file
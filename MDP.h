@@ -2,27 +2,89 @@
 
 #include <m_utils.h>
 
+#include <algorithm>
 #include <chrono>
+#include <memory>
 #include <random>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "StateIndexer.h"
 #include "m_types.h"
 
 template <typename State, typename Action>
 class MDP {
    public:
+    using StateType = State;
+    using ActionType = Action;
     using Transition = std::tuple<State, Reward, Probability>;
     using Dynamics =
         std::unordered_map<std::pair<State, Action>, std::vector<Transition>, StateActionPairHash<State, Action>>;
+    using ActionMask = std::vector<bool>;  // valid actions of a state, indexed like all_actions()
 
    protected:
     std::vector<State> m_S;                                                // State space: S
-    std::vector<State> m_T;                                                // Terminal State space: T
     std::unordered_map<State, std::vector<Action>, StateHash<State>> m_A;  // Action space: A
     Dynamics m_dynamics;                                                   // Dynamics P function (if known)
     bool m_is_continuous;
+    std::unordered_map<State, ActionMask, StateHash<State>> m_action_masks;  // published by publish_action_masks()
+
+    // all_possible_actions() cached on first non-empty use, so all_actions() and actions(s) can return
+    // a reference. Environments that build their actions in initialize() call invalidate_actions().
+    mutable std::vector<Action> m_fallback_actions;
+    mutable bool m_fallback_cached{false};
+
+    void invalidate_actions() { m_fallback_cached = false; }
+
+    // Replaces the terminal states; environments with a finite terminal set call this from
+    // initialize(). m_T is private so the index can never go stale.
+    void set_terminals(std::vector<State> terminals) {
+        m_T = std::move(terminals);
+        m_terminal_bitset_used = false;
+        m_terminal_bitset.clear();
+        m_terminal_set.clear();
+
+        if constexpr (std::is_integral_v<State>) {
+            if (!m_T.empty()) {
+                auto [min_it, max_it] = std::minmax_element(m_T.begin(), m_T.end());
+                unsigned long long span = static_cast<long long>(*max_it) - static_cast<long long>(*min_it) + 1;
+                if (span <= TERMINAL_BITSET_DENSITY * m_T.size()) {
+                    m_terminal_bitset_used = true;
+                    m_terminal_min = *min_it;
+                    m_terminal_bitset.assign(span, false);
+                    for (const State& t : m_T) m_terminal_bitset[static_cast<long long>(t) - m_terminal_min] = true;
+                    return;
+                }
+            }
+        }
+
+        m_terminal_set.insert(m_T.begin(), m_T.end());
+    }
+
+    // Builds the minimal perfect hash over m_S that state_indexer() returns; environments that
+    // enumerate m_S call this at the end of initialize()
+    void index_states() {
+        auto indexer = std::make_shared<StateIndexer<State>>();
+        indexer->build(m_S);
+        m_state_indexer = std::move(indexer);
+    }
+
+   private:
+    std::vector<State> m_T;  // Terminal State space: T
+    std::shared_ptr<const StateIndexer<State>> m_state_indexer;
+
+    // Index over m_T for is_terminal, built by set_terminals(). Integral states that are dense enough
+    // use a bitset over [m_terminal_min, max]; every other State type (all environments in this repo
+    // so far) uses a hash set.
+    static constexpr size_t TERMINAL_BITSET_DENSITY = 64;  // max bits per terminal state
+    bool m_terminal_bitset_used{false};
+    long long m_terminal_min{0};
+    std::vector<bool> m_terminal_bitset;
+    std::unordered_set<State, StateHash<State>> m_terminal_set;
 
    public:
     virtual ~MDP() = default;
@@ -35,6 +97,28 @@ class MDP {
 
     std::vector<State> S() const { return m_S; }
     std::vector<State> T() const { return m_T; }
+
+    // Views into the MDP's own storage; valid for the lifetime of the MDP and never copied
+    const std::vector<State>& states() const { return m_S; }
+    const std::vector<State>& terminals() const { return m_T; }
+    bool terminal_bitset_used() const { return m_terminal_bitset_used; }
+    // Ids in [0, |S|) for the states of m_S, or null if the environment did not call index_states()
+    std::shared_ptr<const StateIndexer<State>> state_indexer() const { return m_state_indexer; }
+    const std::vector<Action>& actions(const State& s) const {
+        auto it = m_A.find(s);
+        if (it != m_A.end()) {
+            return it->second;
+        }
+        return all_actions();
+    }
+    const std::vector<Action>& all_actions() const {
+        if (!m_fallback_cached) {
+            m_fallback_actions = this->all_possible_actions();
+            m_fallback_cached = !m_fallback_actions.empty();
+        }
+        return m_fallback_actions;
+    }
+
     std::vector<Action> A(const State& s, bool fallback = true) const {
         auto it = m_A.find(s);
         if (it != m_A.end()) {
@@ -59,8 +143,16 @@ class MDP {
         throw std::logic_error("is_valid is not implemented in this environment.");
     }
 
-    std::vector<Transition> p(const State& s, const Action& a) const { return m_dynamics.at({s, a}); }
-    Dynamics dynamics() const { return m_dynamics; }
+    // Valid actions of s as a mask over all_actions(), or nullptr if the environment has none for s
+    // (callers then fall back to is_valid)
+    virtual const ActionMask* action_mask(const State& s) const {
+        auto it = m_action_masks.find(s);
+        return it != m_action_masks.end() ? &it->second : nullptr;
+    }
+    bool has_action_masks() const { return !m_action_masks.empty(); }
+
+    const std::vector<Transition>& p(const State& s, const Action& a) const { return m_dynamics.at({s, a}); }
+    const Dynamics& dynamics() const { return m_dynamics; }
 
     virtual State reset() { throw std::logic_error("The reset function is not available in this environment."); }
 
@@ -68,15 +160,45 @@ class MDP {
         throw std::logic_error("The step function is not available in this environment.");
     }
 
+    // Number of primitive time steps the last step() spanned (more than one when actions are repeated)
+    virtual TimeStep step_duration() const { return 1; }
+
+    // Solvers pass their discount rate here, so environments that sum rewards over several
+    // primitive steps discount them the same way
+    virtual void set_discount_rate(double /*discount_rate*/) {}
+
+    // True once the current episode has been cut short (e.g. by a time limit) in a state that is
+    // not terminal: solvers end the episode there but still bootstrap from that state
+    virtual bool truncated() const { return false; }
+
     virtual bool is_terminal(const State& state) {
         if (m_is_continuous) return false;
 
-        return std::find(m_T.begin(), m_T.end(), state) != m_T.end();
+        if constexpr (std::is_integral_v<State>) {
+            if (m_terminal_bitset_used) {
+                long long offset = static_cast<long long>(state) - m_terminal_min;
+                return offset >= 0 && offset < static_cast<long long>(m_terminal_bitset.size()) &&
+                       m_terminal_bitset[offset];
+            }
+        }
+
+        return m_terminal_set.count(state) > 0;
+    }
+
+    // Evaluates is_valid once for every state in m_S so decisions can read the masks instead
+    void publish_action_masks() {
+        const auto& all = all_actions();
+        m_action_masks.clear();
+        for (const State& s : m_S) {
+            ActionMask& mask = m_action_masks[s];
+            mask.resize(all.size());
+            for (size_t i = 0; i < all.size(); i++) mask[i] = is_valid(s, all[i]);
+        }
     }
 
     Action random_action(const State& s) const {
         static std::mt19937 generator{std::random_device{}()};
-        auto actions = this->A(s);
+        const auto& actions = this->actions(s);
         if (actions.empty()) {
             throw std::runtime_error("No available actions for the given state");
         }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
 #include <random>
 #include <stdexcept>
@@ -16,6 +17,12 @@ class MDPSolver {
    protected:
     MDP<State, Action>* m_mdp;
     Policy<State, Action>* m_policy;
+    std::function<void(int)> m_on_episode_end;
+
+    // Solvers call this after every completed episode with its 1-based index
+    void end_episode(int episode) {
+        if (m_on_episode_end) m_on_episode_end(episode);
+    }
 
    public:
     virtual ~MDPSolver() = default;
@@ -30,6 +37,9 @@ class MDPSolver {
     MDP<State, Action>* mdp() { return m_mdp; }
     Policy<State, Action>* policy() { return m_policy; }
 
+    // Runs on the training thread between episodes, e.g. to checkpoint or log progress
+    void set_episode_callback(std::function<void(int)> callback) { m_on_episode_end = std::move(callback); }
+
     std::vector<std::tuple<State, Action, Reward>> generate_episode() {
         std::vector<std::tuple<State, Action, Reward>> episode;
         State state = m_mdp->reset();
@@ -40,7 +50,7 @@ class MDPSolver {
             auto [next_state, reward] = m_mdp->step(state, action);
             episode.emplace_back(state, action, reward);
             state = next_state;
-            done = m_mdp->is_terminal(state);
+            done = m_mdp->is_terminal(state) || m_mdp->truncated();
         }
 
         return episode;
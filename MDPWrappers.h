@@ -0,0 +1,314 @@
+#pragma once
+
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MDP.h"
+#include "StateArchive.h"
+#include "TrajectoryRecorder.h"
+#include "m_types.h"
+
+// Wrappers are mixins that derive from the environment they wrap, e.g.
+// RecordEpisodeStatistics<TimeLimit<ActionRepeat<WindyGridworld>>>. The stack is
+// still an MDP, only the outermost step() is a virtual call and every wrapper
+// reaches the next layer through a qualified, statically bound Env:: call.
+// Wrappers that change step() hide step_repeated, so keep ActionRepeat directly
+// on the environment to use its native repeat. Wrappers with per-run state extend
+// the environment's save_state/load_state when it has them.
+
+template <typename Env, typename = void>
+struct has_step_repeated : std::false_type {};
+
+// Environments can run repeated actions natively (e.g. in one server round trip)
+// by providing step_repeated(s, a, repeat, discount_rate) -> {state, reward, ticks}
+template <typename Env>
+struct has_step_repeated<Env, std::void_t<decltype(std::declval<Env&>().step_repeated(
+                                  std::declval<const typename Env::StateType&>(),
+                                  std::declval<const typename Env::ActionType&>(), 1, 1.0))>> : std::true_type {};
+
+template <typename Env, typename = void>
+struct has_save_state : std::false_type {};
+
+// Environments with per-run state of their own (e.g. a simulator's arena and generator)
+// provide save_state(StateWriter&) and load_state(StateReader&); a remote game does not
+template <typename Env>
+struct has_save_state<Env, std::void_t<decltype(std::declval<const Env&>().save_state(std::declval<StateWriter&>())),
+                                       decltype(std::declval<Env&>().load_state(std::declval<StateReader&>()))>>
+    : std::true_type {};
+
+// Repeats every action for up to `repeat` ticks, stopping early on a terminal state.
+// The returned reward is the sum over the ticks discounted by the solver's rate, and
+// step_duration() reports how many ticks were taken so solvers can discount by gamma^ticks.
+template <typename Env>
+class ActionRepeat : public Env {
+   public:
+    using State = typename Env::StateType;
+    using Action = typename Env::ActionType;
+
+   protected:
+    int m_repeat{1};
+    double m_discount_rate{1};
+    TimeStep m_ticks{1};
+
+   public:
+    using Env::Env;
+
+    void set_action_repeat(int repeat) {
+        if (repeat < 1) {
+            throw std::invalid_argument("Action repeat must be at least 1");
+        }
+        m_repeat = repeat;
+    }
+
+    void set_discount_rate(double discount_rate) override {
+        Env::set_discount_rate(discount_rate);
+        m_discount_rate = discount_rate;
+    }
+
+    int action_repeat() const { return m_repeat; }
+
+    std::pair<State, Reward> step(const State& s, const Action& a) override {
+        if constexpr (has_step_repeated<Env>::value) {
+            auto [next_state, reward, ticks] = Env::step_repeated(s, a, m_repeat, m_discount_rate);
+            m_ticks = ticks;
+            return {next_state, reward};
+        } else {
+            State current = s;
+            Reward total = 0;
+            double discount = 1;
+            m_ticks = 0;
+
+            for (int i = 0; i < m_repeat; i++) {
+                auto [next_state, reward] = Env::step(current, a);
+                total += discount * reward;
+                discount *= m_discount_rate;
+                current = next_state;
+                m_ticks++;
+                if (Env::is_terminal(current)) break;
+            }
+
+            return {current, total};
+        }
+    }
+
+    TimeStep step_duration() const override { return m_ticks; }
+};
+
+// Truncates an episode once `max_steps` decisions have been taken since the last reset.
+// The last state is not terminal, so solvers still bootstrap from it; truncated() is
+// virtual, so the limit is seen from any position in the wrapper stack.
+template <typename Env>
+class TimeLimit : public Env {
+   public:
+    using State = typename Env::StateType;
+    using Action = typename Env::ActionType;
+
+   protected:
+    int m_max_steps{std::numeric_limits<int>::max()};
+    int m_elapsed_steps{0};
+
+   public:
+    using Env::Env;
+
+    void step_repeated() = delete;
+
+    void set_max_steps(int max_steps) { m_max_steps = max_steps; }
+    bool truncated() const override { return m_elapsed_steps >= m_max_steps || Env::truncated(); }
+
+    State reset() override {
+        m_elapsed_steps = 0;
+        return Env::reset();
+    }
+
+    std::pair<State, Reward> step(const State& s, const Action& a) override {
+        m_elapsed_steps++;
+        return Env::step(s, a);
+    }
+
+    void save_state(StateWriter& writer) const {
+        if constexpr (has_save_state<Env>::value) Env::save_state(writer);
+        writer.write(m_elapsed_steps);
+    }
+
+    void load_state(StateReader& reader) {
+        if constexpr (has_save_state<Env>::value) Env::load_state(reader);
+        m_elapsed_steps = reader.read<int>();
+    }
+};
+
+// Maps every observed state through `Discretizer` (a State -> State functor) before
+// the agent sees it. The discretizer must keep terminal states terminal. The wrapped
+// environment keeps stepping from the last raw state, whatever state is passed in.
+template <typename Env, typename Discretizer>
+class DiscretizeObservation : public Env {
+   public:
+    using State = typename Env::StateType;
+    using Action = typename Env::ActionType;
+
+   protected:
+    Discretizer m_discretizer;
+    State m_raw_state{};
+
+   public:
+    using Env::Env;
+
+    void step_repeated() = delete;
+
+    Discretizer& discretizer() { return m_discretizer; }
+
+    State reset() override {
+        m_raw_state = Env::reset();
+        return m_discretizer(m_raw_state);
+    }
+
+    std::pair<State, Reward> step(const State& s, const Action& a) override {
+        auto [next_state, reward] = Env::step(m_raw_state, a);
+        m_raw_state = next_state;
+        return {m_discretizer(next_state), reward};
+    }
+};
+
+template <typename Env>
+class ScaleReward : public Env {
+   public:
+    using State = typename Env::StateType;
+    using Action = typename Env::ActionType;
+
+   protected:
+    double m_scale{1};
+
+   public:
+    using Env::Env;
+
+    void step_repeated() = delete;
+
+    void set_reward_scale(double scale) { m_scale = scale; }
+
+    std::pair<State, Reward> step(const State& s, const Action& a) override {
+        auto [next_state, reward] = Env::step(s, a);
+        return {next_state, m_scale * reward};
+    }
+};
+
+// Records the undiscounted return and length (in decisions) of every finished or
+// truncated episode
+template <typename Env>
+class RecordEpisodeStatistics : public Env {
+   public:
+    using State = typename Env::StateType;
+    using Action = typename Env::ActionType;
+
+   protected:
+    Return m_episode_return{0};
+    int m_episode_length{0};
+    std::vector<Return> m_returns;
+    std::vector<int> m_lengths;
+
+   public:
+    using Env::Env;
+
+    void step_repeated() = delete;
+
+    const std::vector<Return>& episode_returns() const { return m_returns; }
+    const std::vector<int>& episode_lengths() const { return m_lengths; }
+
+    State reset() override {
+        m_episode_return = 0;
+        m_episode_length = 0;
+        return Env::reset();
+    }
+
+    std::pair<State, Reward> step(const State& s, const Action& a) override {
+        auto [next_state, reward] = Env::step(s, a);
+        m_episode_return += reward;
+        m_episode_length++;
+        if (Env::is_terminal(next_state) || this->truncated()) {
+            m_returns.push_back(m_episode_return);
+            m_lengths.push_back(m_episode_length);
+        }
+        return {next_state, reward};
+    }
+
+    // Mean return of the last `n` finished episodes (all of them when n is 0)
+    Return mean_return(size_t n = 0) const {
+        if (m_returns.empty()) return 0;
+        size_t count = (n == 0 || n > m_returns.size()) ? m_returns.size() : n;
+        Return total = 0;
+        for (size_t i = m_returns.size() - count; i < m_returns.size(); i++) total += m_returns[i];
+        return total / count;
+    }
+
+    void save_state(StateWriter& writer) const {
+        if constexpr (has_save_state<Env>::value) Env::save_state(writer);
+        writer.write(m_episode_return);
+        writer.write(m_episode_length);
+        writer.write_vector(m_returns);
+        writer.write_vector(m_lengths);
+    }
+
+    void load_state(StateReader& reader) {
+        if constexpr (has_save_state<Env>::value) Env::load_state(reader);
+        m_episode_return = reader.read<Return>();
+        m_episode_length = reader.read<int>();
+        reader.read_vector(m_returns);
+        reader.read_vector(m_lengths);
+    }
+};
+
+// Records every transition to a TrajectoryRecorder, tagged with the episode it
+// belongs to (1 for the first reset) and the ticks it spanned. `done` is the
+// wrapped environment's terminal flag. Without a recorder it only counts episodes.
+template <typename Env, typename Recorder = TrajectoryRecorder<typename Env::StateType, typename Env::ActionType>>
+class RecordTrajectory : public Env {
+   public:
+    using State = typename Env::StateType;
+    using Action = typename Env::ActionType;
+
+   protected:
+    Recorder* m_recorder{nullptr};
+    uint64_t m_episode{0};
+
+   public:
+    using Env::Env;
+
+    void step_repeated() = delete;
+
+    void set_recorder(Recorder* recorder) { m_recorder = recorder; }
+
+    State reset() override {
+        m_episode++;
+        return Env::reset();
+    }
+
+    std::pair<State, Reward> step(const State& s, const Action& a) override {
+        auto [next_state, reward] = Env::step(s, a);
+        if (m_recorder) {
+            m_recorder->record(s, a, reward, next_state, Env::is_terminal(next_state), m_episode, Env::step_duration());
+        }
+        return {next_state, reward};
+    }
+
+    // Also stores the length of the recorder's file, so a resumed run first drops
+    // the transitions recorded after this state and records them under the same
+    // episode ids again
+    void save_state(StateWriter& writer) const {
+        if constexpr (has_save_state<Env>::value) Env::save_state(writer);
+        writer.write(m_episode);
+        writer.write<uint64_t>(m_recorder ? m_recorder->file_size() : 0);
+    }
+
+    void load_state(StateReader& reader) {
+        if constexpr (has_save_state<Env>::value) Env::load_state(reader);
+        m_episode = reader.read<uint64_t>();
+        uint64_t file_size = reader.read<uint64_t>();
+        if (m_recorder && file_size > 0 && !m_recorder->truncate(file_size)) {
+            std::cerr << "Trajectory file is shorter than when the training state was saved; keeping all of it"
+                      << std::endl;
+        }
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// Read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+   private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+
+    void unmap() {
+        if (m_data) munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+   public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& file_path) {
+        int fd = ::open(file_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file for mapping: " + file_path);
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to map empty or unreadable file: " + file_path);
+        }
+
+        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Failed to map file: " + file_path);
+        }
+
+        m_data = data;
+        m_size = info.st_size;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    ~MappedFile() { unmap(); }
+
+    bool is_open() const { return m_data != nullptr; }
+    const char* data() const { return static_cast<const char*>(m_data); }
+    size_t size() const { return m_size; }
+};
@@ -0,0 +1,499 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FunctionApproximator.h"
+#include "TrajectoryRecorder.h"
+#include "ValueStrategy.h"
+#include "m_types.h"
+#include "m_utils.h"
+
+// Batch reinforcement learning over logged transitions, without an environment.
+// Each iteration computes a target for every transition from the current values,
+// y = r + discount^ticks * Q(s', a') (just r when done), and refits Q to the targets:
+//   FittedQ - a' is the greedy action in s' (fitted Q iteration)
+//   Sarsa   - a' is the action logged after s' in the same episode (batch SARSA);
+//             the last transition of an episode that did not end falls back to the greedy action
+// Transitions are split into contiguous shards, one per thread, and each shard
+// accumulates its own sums, which are combined once per iteration.
+enum class OfflineTarget { FittedQ, Sarsa };
+
+struct OfflineConfig {
+    double discount_rate = 1;
+    int iterations = 50;
+    double tolerance = 0;  // stop early once no value changes by more than this
+    int threads = 0;       // 0 uses every hardware thread
+    double ridge = 1e-6;   // L2 regularization of the linear least-squares fit
+    size_t feature_cache_bytes = size_t{1} << 30;  // linear solver: cached next-state features, see below
+};
+
+namespace offline_detail {
+
+inline int thread_count(int configured) {
+    if (configured > 0) return configured;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs f(shard, begin, end) over `threads` contiguous shards of [0, size)
+template <typename F>
+void for_each_shard(size_t size, int threads, F&& f) {
+    size_t shard_size = (size + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (int shard = 1; shard < threads; shard++) {
+        size_t begin = std::min(size, shard * shard_size);
+        size_t end = std::min(size, begin + shard_size);
+        workers.emplace_back([&f, shard, begin, end] { f(shard, begin, end); });
+    }
+    f(0, 0, std::min(size, shard_size));
+    for (auto& worker : workers) worker.join();
+}
+
+// Cholesky decomposition of a symmetric positive definite A (row-major, n x n), in place:
+// the lower triangle becomes L with A = L L^T
+inline void cholesky(std::vector<double>& A, size_t n) {
+    for (size_t j = 0; j < n; j++) {
+        double diagonal = A[j * n + j];
+        for (size_t k = 0; k < j; k++) diagonal -= A[j * n + k] * A[j * n + k];
+        if (diagonal <= 0) throw std::runtime_error("features are linearly dependent, increase the ridge");
+        A[j * n + j] = std::sqrt(diagonal);
+        for (size_t i = j + 1; i < n; i++) {
+            double value = A[i * n + j];
+            for (size_t k = 0; k < j; k++) value -= A[i * n + k] * A[j * n + k];
+            A[i * n + j] = value / A[j * n + j];
+        }
+    }
+}
+
+// Solves L L^T x = b for the factor L computed by cholesky()
+inline std::vector<double> solve_cholesky(const std::vector<double>& L, std::vector<double> b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        for (size_t k = 0; k < i; k++) b[i] -= L[i * n + k] * b[k];
+        b[i] /= L[i * n + i];
+    }
+    for (size_t i = n; i-- > 0;) {
+        for (size_t k = i + 1; k < n; k++) b[i] -= L[k * n + i] * b[k];
+        b[i] /= L[i * n + i];
+    }
+    return b;
+}
+
+// discount_rate^ticks of each transition, for targets of repeated actions
+template <typename Batch>
+std::vector<double> discounts(const Batch& batch, double discount_rate) {
+    std::vector<double> discounts(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) discounts[i] = std::pow(discount_rate, batch.ticks(i));
+    return discounts;
+}
+
+}  // namespace offline_detail
+
+// Transitions of a trajectory file decoded into memory, with the row that follows
+// each transition in its episode (NO_NEXT if none)
+template <typename State, typename Action>
+class TransitionBatch {
+   public:
+    static constexpr size_t NO_NEXT = static_cast<size_t>(-1);
+
+   private:
+    std::vector<State> m_states;
+    std::vector<Action> m_actions;
+    std::vector<Return> m_rewards;
+    std::vector<uint32_t> m_ticks;
+    std::vector<State> m_next_states;
+    std::vector<uint8_t> m_done;
+    std::vector<size_t> m_next;
+
+   public:
+    template <typename StateCodec, typename ActionCodec>
+    explicit TransitionBatch(const TrajectoryReader<State, Action, StateCodec, ActionCodec>& reader, int threads = 0) {
+        size_t size = reader.size();
+        m_states.resize(size);
+        m_actions.resize(size);
+        m_rewards.resize(size);
+        m_ticks.resize(size);
+        m_next_states.resize(size);
+        m_done.resize(size);
+        m_next.assign(size, NO_NEXT);
+
+        std::vector<size_t> offsets;
+        size_t offset = 0;
+        for (const auto& chunk : reader.chunks()) {
+            offsets.push_back(offset);
+            offset += chunk.size();
+        }
+
+        // Chunks decode independently
+        const auto& chunks = reader.chunks();
+        auto decode = [&](int, size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++) {
+                const auto& chunk = chunks[c];
+                size_t row = offsets[c];
+                std::copy(chunk.rewards(), chunk.rewards() + chunk.size(), m_rewards.begin() + row);
+                std::copy(chunk.ticks(), chunk.ticks() + chunk.size(), m_ticks.begin() + row);
+                std::copy(chunk.done(), chunk.done() + chunk.size(), m_done.begin() + row);
+                for (size_t i = 0; i < chunk.size(); i++) {
+                    m_states[row + i] = chunk.state(i);
+                    m_actions[row + i] = chunk.action(i);
+                    m_next_states[row + i] = chunk.next_state(i);
+                }
+            }
+        };
+        offline_detail::for_each_shard(chunks.size(), offline_detail::thread_count(threads), decode);
+
+        // A recorder writes an episode's transitions in order, so the next row continues it
+        size_t row = 0;
+        uint64_t previous_episode = 0;
+        for (const auto& chunk : chunks) {
+            const uint64_t* episodes = chunk.episodes();
+            for (size_t i = 0; i < chunk.size(); i++, row++) {
+                if (row > 0 && !m_done[row - 1] && episodes[i] == previous_episode) m_next[row - 1] = row;
+                previous_episode = episodes[i];
+            }
+        }
+    }
+
+    size_t size() const { return m_rewards.size(); }
+    const State& state(size_t i) const { return m_states[i]; }
+    const Action& action(size_t i) const { return m_actions[i]; }
+    Return reward(size_t i) const { return m_rewards[i]; }
+    TimeStep ticks(size_t i) const { return m_ticks[i]; }
+    const State& next_state(size_t i) const { return m_next_states[i]; }
+    bool done(size_t i) const { return m_done[i]; }
+    size_t next(size_t i) const { return m_next[i]; }
+};
+
+// Batch learning into a TabularValueStrategy, which the checkpoint and JSON savers
+// then write like an online-trained table. Every (s, a) in the batch becomes one
+// dense slot, so an iteration is array arithmetic: a slot's new value is the mean
+// target of its transitions. Q values of (s', a') pairs outside the batch are
+// read once from the strategy and stay fixed.
+template <typename State, typename Action>
+class OfflineTabularSolver {
+   private:
+    static constexpr uint32_t NONE = static_cast<uint32_t>(-1);
+
+    const TransitionBatch<State, Action>& m_batch;
+    TabularValueStrategy<State, Action>* m_value_strategy;
+    OfflineConfig m_config;
+    int m_threads;
+
+    std::vector<std::pair<State, Action>> m_keys;  // (s, a) of each slot
+    std::vector<uint32_t> m_slot;                  // slot of each transition
+    std::vector<uint32_t> m_next_slot;             // slot of (s', a') taken next, for Sarsa
+    std::vector<uint32_t> m_next_state;            // next-state id of each transition
+    // Per next state: its slots as [m_successor_begin[k], m_successor_begin[k + 1]) of m_successors,
+    // and the best fixed value of its actions without a slot
+    std::vector<uint32_t> m_successor_begin;
+    std::vector<uint32_t> m_successors;
+    std::vector<Return> m_fixed_best;
+    std::vector<uint32_t> m_counts;  // transitions per slot
+    std::vector<double> m_discounts;
+
+    // candidates(s) are the actions of s the greedy a' is chosen from
+    template <typename Candidates>
+    void index(Candidates&& candidates) {
+        std::unordered_map<std::pair<State, Action>, uint32_t, StateActionPairHash<State, Action>> slots;
+        std::unordered_map<State, uint32_t, StateHash<State>> next_states;
+        size_t n = m_batch.size();
+        slots.reserve(n);
+        m_slot.resize(n);
+        m_next_state.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            auto [it, inserted] = slots.try_emplace({m_batch.state(i), m_batch.action(i)}, m_keys.size());
+            if (inserted) m_keys.push_back(it->first);
+            m_slot[i] = it->second;
+            m_next_state[i] = next_states.try_emplace(m_batch.next_state(i), next_states.size()).first->second;
+        }
+
+        m_next_slot.assign(n, NONE);
+        for (size_t i = 0; i < n; i++) {
+            if (m_batch.next(i) != TransitionBatch<State, Action>::NO_NEXT) m_next_slot[i] = m_slot[m_batch.next(i)];
+        }
+
+        std::vector<const State*> by_id(next_states.size());
+        for (const auto& [s, id] : next_states) by_id[id] = &s;
+        m_successor_begin.assign(1, 0);
+        m_fixed_best.reserve(by_id.size());
+        for (const State* s : by_id) {
+            Return fixed = std::numeric_limits<Return>::lowest();
+            for (const Action& a : candidates(*s)) {
+                auto it = slots.find({*s, a});
+                if (it != slots.end()) {
+                    m_successors.push_back(it->second);
+                } else {
+                    fixed = std::max(fixed, m_value_strategy->Q(*s, a));
+                }
+            }
+            m_successor_begin.push_back(m_successors.size());
+            m_fixed_best.push_back(fixed);
+        }
+
+        m_counts.assign(m_keys.size(), 0);
+        for (uint32_t slot : m_slot) m_counts[slot]++;
+        m_discounts = offline_detail::discounts(m_batch, m_config.discount_rate);
+    }
+
+    Return best(const std::vector<Return>& q, uint32_t next_state) const {
+        Return value = m_fixed_best[next_state];
+        for (uint32_t k = m_successor_begin[next_state]; k < m_successor_begin[next_state + 1]; k++) {
+            value = std::max(value, q[m_successors[k]]);
+        }
+        return value;
+    }
+
+   public:
+    // `actions` are the candidates for the greedy a' in every state, e.g. the MDP's all_actions()
+    OfflineTabularSolver(const TransitionBatch<State, Action>& batch, TabularValueStrategy<State, Action>* value_strategy,
+                         const std::vector<Action>& actions, OfflineConfig config = {})
+        : m_batch(batch),
+          m_value_strategy(value_strategy),
+          m_config(config),
+          m_threads(offline_detail::thread_count(config.threads)) {
+        if (!value_strategy) throw std::invalid_argument("OfflineTabularSolver requires a value strategy");
+        if (actions.empty()) throw std::invalid_argument("OfflineTabularSolver requires the candidate actions");
+        index([&actions](const State&) -> const std::vector<Action>& { return actions; });
+    }
+
+    // Greedy a' chosen among mdp.actions(s'), for environments whose actions depend on the state
+    OfflineTabularSolver(const TransitionBatch<State, Action>& batch, TabularValueStrategy<State, Action>* value_strategy,
+                         const MDP<State, Action>& mdp, OfflineConfig config = {})
+        : m_batch(batch),
+          m_value_strategy(value_strategy),
+          m_config(config),
+          m_threads(offline_detail::thread_count(config.threads)) {
+        if (!value_strategy) throw std::invalid_argument("OfflineTabularSolver requires a value strategy");
+        index([&mdp](const State& s) -> const std::vector<Action>& { return mdp.actions(s); });
+    }
+
+    // Returns the number of iterations run
+    int solve(OfflineTarget target) {
+        std::vector<Return> q(m_keys.size());
+        for (size_t slot = 0; slot < m_keys.size(); slot++) {
+            q[slot] = m_value_strategy->Q(m_keys[slot].first, m_keys[slot].second);
+        }
+
+        std::vector<std::vector<Return>> sums(m_threads, std::vector<Return>(m_keys.size()));
+        int iteration = 0;
+        while (iteration < m_config.iterations) {
+            iteration++;
+            offline_detail::for_each_shard(m_batch.size(), m_threads, [&](int shard, size_t begin, size_t end) {
+                std::vector<Return>& sum = sums[shard];
+                std::fill(sum.begin(), sum.end(), 0);
+                for (size_t i = begin; i < end; i++) {
+                    Return y = m_batch.reward(i);
+                    if (!m_batch.done(i)) {
+                        bool sarsa = target == OfflineTarget::Sarsa && m_next_slot[i] != NONE;
+                        y += m_discounts[i] * (sarsa ? q[m_next_slot[i]] : best(q, m_next_state[i]));
+                    }
+                    sum[m_slot[i]] += y;
+                }
+            });
+
+            double change = 0;
+            for (size_t slot = 0; slot < q.size(); slot++) {
+                Return total = 0;
+                for (const auto& sum : sums) total += sum[slot];
+                Return updated = total / m_counts[slot];
+                change = std::max(change, std::abs(updated - q[slot]));
+                q[slot] = updated;
+            }
+            if (change <= m_config.tolerance) break;
+        }
+
+        for (size_t slot = 0; slot < m_keys.size(); slot++) {
+            m_value_strategy->set_q(m_keys[slot].first, m_keys[slot].second, q[slot]);
+        }
+        return iteration;
+    }
+
+    size_t slots() const { return m_keys.size(); }
+};
+
+// Batch learning of linear weights: each iteration is a ridge-regularized least
+// squares fit of w . phi(s, a) to the targets, solved from the normal equations.
+// Features come from the approximator's gradient(), which for a linear
+// approximator is the feature vector. The result is set with set_weights(), so
+// save_approximator() writes the same file as online training.
+template <typename State, typename Action>
+class OfflineLinearSolver {
+   private:
+    const TransitionBatch<State, Action>& m_batch;
+    FunctionApproximator<State, Action>* m_approximator;
+    std::vector<Action> m_actions;
+    OfflineConfig m_config;
+    int m_threads;
+    size_t m_dim;
+
+    std::vector<double> m_features;  // phi(s, a) of each transition, row-major
+    std::vector<double> m_gram;      // Cholesky factor of sum of phi phi^T plus the ridge, the same every iteration
+    std::vector<double> m_discounts;
+
+    const double* features(size_t i) const { return &m_features[i * m_dim]; }
+
+    double dot(const std::vector<double>& w, const double* phi) const {
+        double value = 0;
+        for (size_t k = 0; k < m_dim; k++) value += w[k] * phi[k];
+        return value;
+    }
+
+    // Maxima over actions read phi(s', a) of every candidate action. Transitions that share a
+    // next state share its id, and the features of the first ids are cached, up to
+    // feature_cache_bytes, on the first solve that needs them. Next states past the cache
+    // are recomputed on every iteration.
+    static constexpr uint32_t NONE = static_cast<uint32_t>(-1);
+    std::vector<uint32_t> m_next_state;  // next-state id of each transition that is not done
+    std::vector<size_t> m_next_source;   // a transition with each next state
+    size_t m_cached_states{0};
+    std::vector<double> m_next_features;  // rows of |actions| * m_dim, one per cached id
+    std::vector<uint8_t> m_next_ready;
+
+    bool needs_best(size_t i, OfflineTarget target) const {
+        return !m_batch.done(i) &&
+               (target == OfflineTarget::FittedQ || m_batch.next(i) == TransitionBatch<State, Action>::NO_NEXT);
+    }
+
+    void index_next_states() {
+        std::unordered_map<State, uint32_t, StateHash<State>> ids;
+        m_next_state.assign(m_batch.size(), NONE);
+        for (size_t i = 0; i < m_batch.size(); i++) {
+            if (m_batch.done(i)) continue;
+            auto [it, inserted] = ids.try_emplace(m_batch.next_state(i), m_next_source.size());
+            if (inserted) m_next_source.push_back(i);
+            m_next_state[i] = it->second;
+        }
+
+        size_t row_bytes = m_actions.size() * m_dim * sizeof(double);
+        m_cached_states = std::min(m_next_source.size(), m_config.feature_cache_bytes / row_bytes);
+        m_next_ready.assign(m_cached_states, 0);
+    }
+
+    void prepare_next_features(OfflineTarget target) {
+        std::vector<uint32_t> missing;
+        std::vector<uint8_t> listed(m_cached_states);
+        for (size_t i = 0; i < m_batch.size(); i++) {
+            uint32_t id = m_next_state[i];
+            if (id < m_cached_states && !m_next_ready[id] && !listed[id] && needs_best(i, target)) {
+                listed[id] = 1;
+                missing.push_back(id);
+            }
+        }
+        if (missing.empty()) return;
+
+        size_t row_size = m_actions.size() * m_dim;
+        m_next_features.resize(m_cached_states * row_size);
+        offline_detail::for_each_shard(missing.size(), m_threads, [&](int, size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++) {
+                double* row = &m_next_features[missing[k] * row_size];
+                const State& next_state = m_batch.next_state(m_next_source[missing[k]]);
+                for (const Action& a : m_actions) {
+                    std::vector<double> phi = m_approximator->gradient(next_state, a);
+                    row = std::copy(phi.begin(), phi.end(), row);
+                }
+            }
+        });
+        for (uint32_t id : missing) m_next_ready[id] = 1;
+    }
+
+    double best(const std::vector<double>& w, size_t i) const {
+        uint32_t id = m_next_state[i];
+        double value = std::numeric_limits<double>::lowest();
+        if (id < m_cached_states) {
+            const double* phi = &m_next_features[id * m_actions.size() * m_dim];
+            for (size_t a = 0; a < m_actions.size(); a++, phi += m_dim) value = std::max(value, dot(w, phi));
+        } else {
+            for (const Action& a : m_actions) {
+                value = std::max(value, dot(w, m_approximator->gradient(m_batch.next_state(i), a).data()));
+            }
+        }
+        return value;
+    }
+
+   public:
+    OfflineLinearSolver(const TransitionBatch<State, Action>& batch, FunctionApproximator<State, Action>* approximator,
+                        const std::vector<Action>& actions, OfflineConfig config = {})
+        : m_batch(batch),
+          m_approximator(approximator),
+          m_actions(actions),
+          m_config(config),
+          m_threads(offline_detail::thread_count(config.threads)) {
+        if (!approximator) throw std::invalid_argument("OfflineLinearSolver requires an approximator");
+        if (actions.empty()) throw std::invalid_argument("OfflineLinearSolver requires the candidate actions");
+        m_dim = approximator->get_weights().size();
+        if (batch.size() > 0 && approximator->gradient(batch.state(0), batch.action(0)).size() != m_dim) {
+            throw std::runtime_error("feature count differs from the weight count");
+        }
+
+        m_features.resize(batch.size() * m_dim);
+        std::vector<std::vector<double>> grams(m_threads, std::vector<double>(m_dim * m_dim));
+        offline_detail::for_each_shard(batch.size(), m_threads, [&](int shard, size_t begin, size_t end) {
+            std::vector<double>& gram = grams[shard];
+            for (size_t i = begin; i < end; i++) {
+                std::vector<double> phi = approximator->gradient(batch.state(i), batch.action(i));
+                std::copy(phi.begin(), phi.end(), m_features.begin() + i * m_dim);
+                for (size_t r = 0; r < m_dim; r++) {
+                    for (size_t c = 0; c < m_dim; c++) gram[r * m_dim + c] += phi[r] * phi[c];
+                }
+            }
+        });
+
+        m_gram.assign(m_dim * m_dim, 0);
+        for (const auto& gram : grams) {
+            for (size_t k = 0; k < gram.size(); k++) m_gram[k] += gram[k];
+        }
+        for (size_t k = 0; k < m_dim; k++) m_gram[k * m_dim + k] += m_config.ridge * std::max<size_t>(1, batch.size());
+        offline_detail::cholesky(m_gram, m_dim);
+        m_discounts = offline_detail::discounts(batch, m_config.discount_rate);
+        index_next_states();
+    }
+
+    // Returns the number of iterations run
+    int solve(OfflineTarget target) {
+        prepare_next_features(target);
+        std::vector<double> w = m_approximator->get_weights();
+        std::vector<std::vector<double>> rhs(m_threads, std::vector<double>(m_dim));
+
+        int iteration = 0;
+        while (iteration < m_config.iterations) {
+            iteration++;
+            offline_detail::for_each_shard(m_batch.size(), m_threads, [&](int shard, size_t begin, size_t end) {
+                std::vector<double>& b = rhs[shard];
+                std::fill(b.begin(), b.end(), 0);
+                for (size_t i = begin; i < end; i++) {
+                    double y = m_batch.reward(i);
+                    if (needs_best(i, target)) {
+                        y += m_discounts[i] * best(w, i);
+                    } else if (!m_batch.done(i)) {
+                        y += m_discounts[i] * dot(w, features(m_batch.next(i)));
+                    }
+                    const double* phi = features(i);
+                    for (size_t k = 0; k < m_dim; k++) b[k] += y * phi[k];
+                }
+            });
+
+            std::vector<double> b(m_dim);
+            for (const auto& shard : rhs) {
+                for (size_t k = 0; k < m_dim; k++) b[k] += shard[k];
+            }
+            std::vector<double> updated = offline_detail::solve_cholesky(m_gram, std::move(b), m_dim);
+
+            double change = 0;
+            for (size_t k = 0; k < m_dim; k++) change = std::max(change, std::abs(updated[k] - w[k]));
+            w = std::move(updated);
+            if (change <= m_config.tolerance) break;
+        }
+
+        m_approximator->set_weights(w);
+        return iteration;
+    }
+};
@@ -2,8 +2,10 @@
 #include <MDPSolver.h>
 #include <ValueStrategy.h>
 
+#include <algorithm>
 #include <unordered_map>
 
+#include "StateArchive.h"
 #include "m_types.h"
 
 template <typename State, typename Action>
@@ -36,6 +38,17 @@ class Policy {
 
     virtual std::tuple<Action, Return> greedy_action(const State& s) { return m_value_strategy->get_best_action(s); }
 
+    // Internal state that affects future samples (RNG, exploration rate), for training-state archives
+    virtual void save_state(StateWriter&) const {}
+    virtual void load_state(StateReader&) {}
+
+    // Non-virtual counterpart of sample() for solvers that know the concrete types;
+    // `greedy` returns the greedy action for a state.
+    template <typename Env, typename Greedy>
+    Action sample_static(Env& env, const State& s, Greedy&& greedy) {
+        return greedy(s);
+    }
+
     std::unordered_map<State, Action, StateHash<State>> optimal() const {
         if (!m_mdp || !m_value_strategy) {
             throw std::logic_error("Policy not properly initialized with MDP and ValueStrategy");
@@ -43,7 +56,7 @@ class Policy {
 
         std::unordered_map<State, Action, StateHash<State>> optimal_policy;
 
-        for (const State& s : m_mdp->S()) {
+        for (const State& s : m_mdp->states()) {
             if (!m_mdp->is_terminal(s)) {
                 auto [best_action, _] = const_cast<Policy*>(this)->greedy_action(s);
                 optimal_policy[s] = best_action;
@@ -75,6 +88,15 @@ class DeterministicPolicy : public Policy<State, Action> {
         }
         return std::get<0>(this->greedy_action(s));
     }
+
+    template <typename Env, typename Greedy>
+    Action sample_static(Env& env, const State& s, Greedy&& greedy) {
+        auto it = m_policy_map.find(s);
+        if (it != m_policy_map.end()) {
+            return it->second;
+        }
+        return greedy(s);
+    }
 };
 
 template <typename State, typename Action>
@@ -83,6 +105,32 @@ class EpsilonGreedyPolicy : public Policy<State, Action> {
     double m_epsilon;
     std::mt19937 m_generator;
 
+    bool explore() {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        return dist(m_generator) < m_epsilon;
+    }
+
+    Action random_action(const std::vector<Action>& actions) {
+        if (actions.empty()) {
+            throw std::runtime_error("No available actions for the given state");
+        }
+        std::uniform_int_distribution<int> action_dist(0, actions.size() - 1);
+        return actions[action_dist(m_generator)];
+    }
+
+    Action random_action(const std::vector<Action>& actions, const std::vector<bool>& mask) {
+        int valid = std::count(mask.begin(), mask.end(), true);
+        if (valid == 0) {
+            throw std::runtime_error("No available actions for the given state");
+        }
+        std::uniform_int_distribution<int> action_dist(0, valid - 1);
+        int k = action_dist(m_generator);
+        for (size_t i = 0; i < actions.size(); i++) {
+            if (mask[i] && k-- == 0) return actions[i];
+        }
+        throw std::logic_error("Action mask does not match the action list");
+    }
+
    public:
     EpsilonGreedyPolicy(ValueStrategy<State, Action>* value_strategy, double epsilon)
         : Policy<State, Action>(value_strategy), m_epsilon(epsilon), m_generator(std::random_device{}()) {
@@ -91,17 +139,32 @@ class EpsilonGreedyPolicy : public Policy<State, Action> {
         }
     }
 
+    void save_state(StateWriter& writer) const override {
+        writer.write(m_epsilon);
+        writer.write_engine(m_generator);
+    }
+
+    void load_state(StateReader& reader) override {
+        m_epsilon = reader.read<double>();
+        reader.read_engine(m_generator);
+    }
+
     Action sample(const State& s) override {
-        std::uniform_real_distribution<double> dist(0.0, 1.0);
-        if (dist(m_generator) < m_epsilon) {
-            auto actions = this->m_mdp->A(s);
-            if (actions.empty()) {
-                throw std::runtime_error("No available actions for the given state");
-            }
-            std::uniform_int_distribution<int> action_dist(0, actions.size() - 1);
-            return actions[action_dist(m_generator)];
+        if (explore()) {
+            const auto* mask = this->m_mdp->action_mask(s);
+            return mask ? random_action(this->m_mdp->all_actions(), *mask) : random_action(this->m_mdp->actions(s));
         } else {
             return std::get<0>(this->greedy_action(s));
         }
     }
+
+    template <typename Env, typename Greedy>
+    Action sample_static(Env& env, const State& s, Greedy&& greedy) {
+        if (explore()) {
+            const auto* mask = env.Env::action_mask(s);
+            return mask ? random_action(env.Env::all_actions(), *mask) : random_action(env.Env::actions(s));
+        } else {
+            return greedy(s);
+        }
+    }
 };
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "MDP.h"
+#include "StateArchive.h"
+#include "StateIndexer.h"
+#include "m_utils.h"
+
+// One value per (state, action) pair, stored densely for the states of MDP::state_indexer():
+// the actions of a state form a contiguous row of slots in the order of MDP::actions(s), so a
+// greedy scan costs one index lookup. Pairs of other states, or all pairs when the MDP has no
+// indexer, go to a hash map. Slots start at Value{}.
+template <typename State, typename Action, typename Value>
+class StateActionTable {
+   private:
+    using Map = std::unordered_map<std::pair<State, Action>, Value, StateActionPairHash<State, Action>>;
+
+    std::shared_ptr<const StateIndexer<State>> m_indexer;
+    std::vector<size_t> m_offsets{0};  // first slot of each row, one entry per state id plus the end
+    std::vector<Action> m_actions;     // action of each slot
+    std::vector<Value> m_values;
+    Map m_overflow;
+
+   public:
+    static constexpr size_t NOT_FOUND = StateIndexer<State>::NOT_FOUND;
+
+    void initialize(const MDP<State, Action>& mdp) {
+        m_indexer = mdp.state_indexer();
+        m_offsets.assign(1, 0);
+        m_actions.clear();
+        m_overflow.clear();
+        if (m_indexer) {
+            for (size_t id = 0; id < m_indexer->size(); id++) {
+                const auto& actions = mdp.actions(m_indexer->state(id));
+                m_actions.insert(m_actions.end(), actions.begin(), actions.end());
+                m_offsets.push_back(m_actions.size());
+            }
+        }
+        m_values.assign(m_actions.size(), Value{});
+    }
+
+    // Row of s, or NOT_FOUND if its pairs are in the map
+    size_t row(const State& s) const { return m_indexer ? m_indexer->index(s) : NOT_FOUND; }
+    size_t row_begin(size_t row) const { return m_offsets[row]; }
+    size_t row_end(size_t row) const { return m_offsets[row + 1]; }
+
+    Action action(size_t slot) const { return m_actions[slot]; }
+    const Value& value(size_t slot) const { return m_values[slot]; }
+    Value& value(size_t slot) { return m_values[slot]; }
+
+    // Slot of a in the row, or NOT_FOUND if a is not one of the state's actions
+    size_t slot(size_t row, const Action& a) const {
+        for (size_t i = m_offsets[row]; i < m_offsets[row + 1]; i++) {
+            if (m_actions[i] == a) return i;
+        }
+        return NOT_FOUND;
+    }
+
+    const Value* find(const State& s, const Action& a) const {
+        size_t r = row(s);
+        if (r != NOT_FOUND) {
+            size_t i = slot(r, a);
+            if (i != NOT_FOUND) return &m_values[i];
+        }
+        auto it = m_overflow.find({s, a});
+        return it != m_overflow.end() ? &it->second : nullptr;
+    }
+
+    Value get(const State& s, const Action& a) const {
+        const Value* value = find(s, a);
+        return value ? *value : Value{};
+    }
+
+    Value& operator[](const std::pair<State, Action>& key) {
+        size_t r = row(key.first);
+        if (r != NOT_FOUND) {
+            size_t i = slot(r, key.second);
+            if (i != NOT_FOUND) return m_values[i];
+        }
+        return m_overflow[key];
+    }
+
+    // Every slot and map entry as a map, e.g. for serialize_to_json
+    Map to_map() const {
+        Map map(m_overflow);
+        map.reserve(m_overflow.size() + m_values.size());
+        for (size_t r = 0; r + 1 < m_offsets.size(); r++) {
+            State s = m_indexer->state(r);
+            for (size_t i = m_offsets[r]; i < m_offsets[r + 1]; i++) map[{s, m_actions[i]}] = m_values[i];
+        }
+        return map;
+    }
+
+    // Written as a map, so the format does not depend on the MDP's indexer
+    void save_state(StateWriter& writer) const { writer.write_map(to_map()); }
+
+    void load_state(StateReader& reader) {
+        Map map;
+        reader.read_map(map);
+        std::fill(m_values.begin(), m_values.end(), Value{});
+        m_overflow.clear();
+        for (const auto& [key, value] : map) (*this)[key] = value;
+    }
+};
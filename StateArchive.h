@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+#include "StateCodec.h"
+#include "m_utils.h"
+
+// Binary archive of the complete learning state of a training run, so a run can
+// be stopped and resumed exactly where it left off. Components provide
+//   void save_state(StateWriter&) const
+//   void load_state(StateReader&)
+// and read back exactly what they wrote, in the same order. Maps are stored with
+// their key type signature and random engines in their standard text form, so a
+// mismatched restore fails instead of reading garbage.
+class StateWriter {
+   private:
+    std::vector<char> m_bytes;
+
+    template <typename T>
+    void write_value(const T& value) {
+        write(value);
+    }
+    template <typename T>
+    void write_value(const std::vector<T>& values) {
+        write_vector(values);
+    }
+
+   public:
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "write() takes plain values");
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(T));
+    }
+
+    void write_string(const std::string& s) {
+        write<uint64_t>(s.size());
+        m_bytes.insert(m_bytes.end(), s.begin(), s.end());
+    }
+
+    template <typename T>
+    void write_vector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "write_vector() takes vectors of plain values");
+        write<uint64_t>(values.size());
+        const char* bytes = reinterpret_cast<const char*>(values.data());
+        m_bytes.insert(m_bytes.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+    void write_vector(const std::vector<bool>& values) { write_vector(std::vector<uint8_t>(values.begin(), values.end())); }
+
+    // Keys via FlatCodec, values plain or vectors of plain values
+    template <typename Map>
+    void write_map(const Map& map) {
+        using KeyCodec = FlatCodec<typename Map::key_type>;
+        write_string(KeyCodec::signature());
+        write<uint64_t>(map.size());
+        int32_t words[KeyCodec::WIDTH];
+        for (const auto& [key, value] : map) {
+            KeyCodec::encode(key, words);
+            for (int32_t word : words) write(word);
+            write_value(value);
+        }
+    }
+
+    template <typename Engine>
+    void write_engine(const Engine& engine) {
+        std::ostringstream text;
+        text << engine;
+        write_string(text.str());
+    }
+
+    // Empties the archive but keeps its storage, for reuse by the next snapshot
+    void clear() { m_bytes.clear(); }
+
+    const std::vector<char>& bytes() const { return m_bytes; }
+};
+
+class StateReader {
+   private:
+    const char* m_pos;
+    const char* m_end;
+
+    const char* take(size_t size) {
+        if (static_cast<size_t>(m_end - m_pos) < size) throw std::runtime_error("training state is truncated");
+        const char* at = m_pos;
+        m_pos += size;
+        return at;
+    }
+
+    template <typename T>
+    void read_value(T& value) {
+        value = read<T>();
+    }
+    template <typename T>
+    void read_value(std::vector<T>& values) {
+        read_vector(values);
+    }
+
+   public:
+    StateReader(const char* data, size_t size) : m_pos(data), m_end(data + size) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>, "read() returns plain values");
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string read_string() {
+        size_t size = read<uint64_t>();
+        return std::string(take(size), size);
+    }
+
+    template <typename T>
+    void read_vector(std::vector<T>& values) {
+        size_t size = read<uint64_t>();
+        values.resize(size);
+        std::memcpy(values.data(), take(size * sizeof(T)), size * sizeof(T));
+    }
+
+    void read_vector(std::vector<bool>& values) {
+        std::vector<uint8_t> bytes;
+        read_vector(bytes);
+        values.assign(bytes.begin(), bytes.end());
+    }
+
+    // Replaces the contents of `map`
+    template <typename Map>
+    void read_map(Map& map) {
+        using KeyCodec = FlatCodec<typename Map::key_type>;
+        using Value = typename Map::mapped_type;
+        if (read_string() != KeyCodec::signature()) throw std::runtime_error("map key type does not match the file");
+
+        size_t size = read<uint64_t>();
+        map.clear();
+        map.reserve(size);
+        int32_t words[KeyCodec::WIDTH];
+        for (size_t i = 0; i < size; i++) {
+            for (int32_t& word : words) word = read<int32_t>();
+            Value value;
+            read_value(value);
+            map.emplace(KeyCodec::decode(words), std::move(value));
+        }
+    }
+
+    template <typename Engine>
+    void read_engine(Engine& engine) {
+        std::istringstream text(read_string());
+        text >> engine;
+        if (!text) throw std::runtime_error("invalid random engine state");
+    }
+
+    bool at_end() const { return m_pos == m_end; }
+};
+
+namespace state_archive_detail {
+
+constexpr char MAGIC[4] = {'R', 'L', 'T', 'S'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+}  // namespace state_archive_detail
+
+// Serializes the parts, in order, into `writer` (which is cleared first)
+template <typename... Parts>
+void capture_training_state(StateWriter& writer, const Parts&... parts) {
+    writer.clear();
+    (parts.save_state(writer), ...);
+}
+
+// Writes a captured state to output_dir + file_path
+inline bool write_training_state(const StateWriter& writer, const std::string& file_path) {
+    using namespace state_archive_detail;
+    const auto& payload = writer.bytes();
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.size = payload.size();
+    header.checksum = fnv1a(FNV_OFFSET, payload.data(), payload.size());
+
+    std::ofstream file(output_dir + file_path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing training state: " << file_path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(payload.data(), payload.size());
+    if (!file) {
+        std::cerr << "Failed to write training state: " << file_path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Saves the parts in order to output_dir + file_path, e.g.
+// save_training_state("run.state", solver, environment)
+template <typename... Parts>
+bool save_training_state(const std::string& file_path, const Parts&... parts) {
+    StateWriter writer;
+    capture_training_state(writer, parts...);
+    return write_training_state(writer, file_path);
+}
+
+// Restores parts saved by save_training_state, in the same order. The file is
+// verified before anything is restored, but a part whose type differs from the
+// file can fail after earlier parts were already overwritten.
+template <typename... Parts>
+bool load_training_state(const std::string& file_path, Parts&... parts) {
+    using namespace state_archive_detail;
+    try {
+        MappedFile file(file_path);
+
+        Header header;
+        if (file.size() < sizeof(header)) throw std::runtime_error("file too small");
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            throw std::runtime_error("not a training state file of version " + std::to_string(VERSION));
+        }
+        if (file.size() != sizeof(header) + header.size) throw std::runtime_error("truncated or oversized file");
+        const char* payload = file.data() + sizeof(header);
+        if (fnv1a(FNV_OFFSET, payload, header.size) != header.checksum) throw std::runtime_error("checksum mismatch");
+
+        StateReader reader(payload, header.size);
+        (parts.load_state(reader), ...);
+        if (!reader.at_end()) throw std::runtime_error("file holds more state than was restored");
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load training state: " << e.what() << std::endl;
+        return false;
+    }
+}
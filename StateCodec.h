@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Fixed-width binary encoding of states and actions as int32 words, for the
+// binary artifacts (compiled policies, checkpoints). Supports integral and
+// enum types, std::pair and std::tuple, nested to any depth. 64-bit integers
+// take two words, low word first.
+template <typename T, typename = void>
+struct FlatCodec;
+
+template <typename T>
+struct FlatCodec<T, std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>> {
+    static_assert(sizeof(T) <= 8, "FlatCodec encodes integers of up to 64 bits");
+    static constexpr size_t WIDTH = sizeof(T) > 4 ? 2 : 1;
+
+    static void encode(const T& value, int32_t* out) {
+        if constexpr (WIDTH == 1) {
+            out[0] = static_cast<int32_t>(value);
+        } else {
+            uint64_t bits = static_cast<uint64_t>(value);
+            out[0] = static_cast<int32_t>(static_cast<uint32_t>(bits));
+            out[1] = static_cast<int32_t>(static_cast<uint32_t>(bits >> 32));
+        }
+    }
+    static T decode(const int32_t* in) {
+        if constexpr (WIDTH == 1) {
+            return static_cast<T>(in[0]);
+        } else {
+            return static_cast<T>(static_cast<uint64_t>(static_cast<uint32_t>(in[0])) |
+                                  static_cast<uint64_t>(static_cast<uint32_t>(in[1])) << 32);
+        }
+    }
+    // Type description stored in binary headers, e.g. "(i32,(i32,b))"
+    static std::string signature() {
+        if constexpr (std::is_same_v<T, bool>) return "b";
+        std::string kind = std::is_enum_v<T> ? "e" : std::is_signed_v<T> ? "i" : "u";
+        return kind + std::to_string(8 * sizeof(T));
+    }
+};
+
+template <typename A, typename B>
+struct FlatCodec<std::pair<A, B>> {
+    static constexpr size_t WIDTH = FlatCodec<A>::WIDTH + FlatCodec<B>::WIDTH;
+
+    static void encode(const std::pair<A, B>& value, int32_t* out) {
+        FlatCodec<A>::encode(value.first, out);
+        FlatCodec<B>::encode(value.second, out + FlatCodec<A>::WIDTH);
+    }
+    static std::pair<A, B> decode(const int32_t* in) {
+        return {FlatCodec<A>::decode(in), FlatCodec<B>::decode(in + FlatCodec<A>::WIDTH)};
+    }
+    static std::string signature() { return "(" + FlatCodec<A>::signature() + "," + FlatCodec<B>::signature() + ")"; }
+};
+
+template <typename... Ts>
+struct FlatCodec<std::tuple<Ts...>> {
+    static constexpr size_t WIDTH = (FlatCodec<Ts>::WIDTH + ... + 0);
+
+    static void encode(const std::tuple<Ts...>& value, int32_t* out) {
+        encode_elements(value, out, std::index_sequence_for<Ts...>{});
+    }
+    static std::tuple<Ts...> decode(const int32_t* in) { return decode_elements(in, std::index_sequence_for<Ts...>{}); }
+    static std::string signature() {
+        std::string elements;
+        ((elements += (elements.empty() ? "" : ",") + FlatCodec<Ts>::signature()), ...);
+        return "(" + elements + ")";
+    }
+
+   private:
+    template <size_t I>
+    static constexpr size_t offset() {
+        constexpr size_t widths[] = {FlatCodec<Ts>::WIDTH..., 0};
+        size_t sum = 0;
+        for (size_t i = 0; i < I; i++) sum += widths[i];
+        return sum;
+    }
+
+    template <size_t... Is>
+    static void encode_elements(const std::tuple<Ts...>& value, int32_t* out, std::index_sequence<Is...>) {
+        (FlatCodec<Ts>::encode(std::get<Is>(value), out + offset<Is>()), ...);
+    }
+
+    template <size_t... Is>
+    static std::tuple<Ts...> decode_elements(const int32_t* in, std::index_sequence<Is...>) {
+        return {FlatCodec<Ts>::decode(in + offset<Is>())...};
+    }
+};
+
+// Layout of a value packed by PackedCodec: Bounds<Lo, Hi> for an integral or bool
+// field holding values in [Lo, Hi], Fields<...> for a pair or tuple with one
+// layout per element.
+template <int64_t Lo, int64_t Hi>
+struct Bounds {
+    static_assert(Lo <= Hi, "Bounds must not be empty");
+    static constexpr int64_t LO = Lo;
+    static constexpr int64_t HI = Hi;
+    static constexpr int BITS = [] {
+        int bits = 0;
+        while (bits < 63 && (uint64_t{1} << bits) < static_cast<uint64_t>(Hi - Lo) + 1) bits++;
+        return bits;
+    }();
+
+    static std::string signature() { return "[" + std::to_string(Lo) + "," + std::to_string(Hi) + "]"; }
+};
+
+template <typename... Layouts>
+struct Fields {
+    static std::string signature() {
+        std::string fields;
+        ((fields += (fields.empty() ? "" : ",") + Layouts::signature()), ...);
+        return "(" + fields + ")";
+    }
+};
+
+[[noreturn]] inline void throw_outside_bounds(int64_t value, int64_t lo, int64_t hi) {
+    throw std::out_of_range("Value " + std::to_string(value) + " outside of packed bounds [" + std::to_string(lo) +
+                            ", " + std::to_string(hi) + "]");
+}
+
+template <typename T, typename Layout>
+struct PackedField;
+
+template <typename T, int64_t Lo, int64_t Hi>
+struct PackedField<T, Bounds<Lo, Hi>> {
+    static constexpr int BITS = Bounds<Lo, Hi>::BITS;
+
+    static void encode(const T& value, uint64_t& key) {
+        int64_t v = static_cast<int64_t>(value);
+        uint64_t offset = static_cast<uint64_t>(v - Lo);
+        if (offset > static_cast<uint64_t>(Hi - Lo)) throw_outside_bounds(v, Lo, Hi);
+        key = (key << BITS) | offset;
+    }
+    static T decode(uint64_t& key) {
+        T value = static_cast<T>(static_cast<int64_t>(key & ((uint64_t{1} << BITS) - 1)) + Lo);
+        key >>= BITS;
+        return value;
+    }
+};
+
+template <typename A, typename B, typename LayoutA, typename LayoutB>
+struct PackedField<std::pair<A, B>, Fields<LayoutA, LayoutB>> {
+    static constexpr int BITS = PackedField<A, LayoutA>::BITS + PackedField<B, LayoutB>::BITS;
+
+    static void encode(const std::pair<A, B>& value, uint64_t& key) {
+        PackedField<A, LayoutA>::encode(value.first, key);
+        PackedField<B, LayoutB>::encode(value.second, key);
+    }
+    static std::pair<A, B> decode(uint64_t& key) {
+        B second = PackedField<B, LayoutB>::decode(key);  // fields come out in reverse order
+        return {PackedField<A, LayoutA>::decode(key), second};
+    }
+};
+
+template <typename... Ts, typename... Layouts>
+struct PackedField<std::tuple<Ts...>, Fields<Layouts...>> {
+    static_assert(sizeof...(Ts) == sizeof...(Layouts), "One layout per tuple element");
+    static constexpr int BITS = (PackedField<Ts, Layouts>::BITS + ... + 0);
+
+    static void encode(const std::tuple<Ts...>& value, uint64_t& key) {
+        std::apply([&key](const Ts&... elements) { (PackedField<Ts, Layouts>::encode(elements, key), ...); }, value);
+    }
+    static std::tuple<Ts...> decode(uint64_t& key) {
+        std::tuple<Ts...> value;
+        decode_elements(value, key, std::index_sequence_for<Ts...>{});
+        return value;
+    }
+
+   private:
+    template <size_t... Is>
+    static void decode_elements(std::tuple<Ts...>& value, uint64_t& key, std::index_sequence<Is...>) {
+        constexpr size_t last = sizeof...(Ts) - 1;
+        ((std::get<last - Is>(value) =
+              PackedField<std::tuple_element_t<last - Is, std::tuple<Ts...>>,
+                          std::tuple_element_t<last - Is, std::tuple<Layouts...>>>::decode(key)),
+         ...);
+    }
+};
+
+// Packs a bounded state or action into the low BITS bits of a uint64_t, first
+// field in the highest bits. Values outside their Bounds throw std::out_of_range.
+// It also has FlatCodec's interface, one or two int32 words per value, so binary
+// files such as trajectory files can store packed columns.
+template <typename T, typename Layout>
+struct PackedCodec {
+    static constexpr int BITS = PackedField<T, Layout>::BITS;
+    static_assert(BITS <= 64, "Packed layout does not fit in 64 bits");
+    static constexpr size_t WIDTH = BITS > 32 ? 2 : 1;
+
+    static uint64_t encode(const T& value) {
+        uint64_t key = 0;
+        PackedField<T, Layout>::encode(value, key);
+        return key;
+    }
+    static T decode(uint64_t key) { return PackedField<T, Layout>::decode(key); }
+
+    static void encode(const T& value, int32_t* out) {
+        if constexpr (WIDTH == 1) {
+            FlatCodec<uint32_t>::encode(static_cast<uint32_t>(encode(value)), out);
+        } else {
+            FlatCodec<uint64_t>::encode(encode(value), out);
+        }
+    }
+    static T decode(const int32_t* in) {
+        if constexpr (WIDTH == 1) {
+            return decode(uint64_t{FlatCodec<uint32_t>::decode(in)});
+        } else {
+            return decode(FlatCodec<uint64_t>::decode(in));
+        }
+    }
+    static std::string signature() { return "p" + Layout::signature(); }
+};
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "StateCodec.h"
+#include "m_utils.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace indexer_detail {
+// High 64 bits of a * b
+inline uint64_t multiply_high(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return __umulh(a, b);
+#else
+    uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32, b_lo = b & 0xffffffff, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+    return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
+
+inline int popcount(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(x));
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+}  // namespace indexer_detail
+
+// Maps each state of a fixed state set to an id in [0, size()).
+// Indexers are built once over the set and answer NOT_FOUND for states outside it.
+// save() writes an image of the indexer (a multiple of 8 bytes) that attach() reads
+// back from memory, e.g. a mapped file that must outlive the indexer.
+template <typename State>
+class HashStateIndexer {
+   private:
+    using Codec = FlatCodec<State>;
+
+    std::unordered_map<State, size_t, StateHash<State>> m_ids;
+    std::vector<State> m_states;  // state of each id
+
+   public:
+    static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+    // Ids follow the order in which states first appear in `states`
+    void build(const std::vector<State>& states) {
+        m_ids.clear();
+        m_states.clear();
+        m_ids.reserve(states.size());
+        for (const State& s : states) {
+            if (m_ids.emplace(s, m_ids.size()).second) m_states.push_back(s);
+        }
+    }
+
+    size_t index(const State& s) const {
+        auto it = m_ids.find(s);
+        return it != m_ids.end() ? it->second : NOT_FOUND;
+    }
+
+    const State& state(size_t id) const { return m_states[id]; }
+
+    size_t size() const { return m_ids.size(); }
+
+    // Image: uint64 state count, then the states in id order (Codec words), padded to 8 bytes
+    void save(std::ostream& out) const {
+        uint64_t count = m_states.size();
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        std::vector<int32_t> words((Codec::WIDTH * m_states.size() + 1) / 2 * 2, 0);
+        for (size_t i = 0; i < m_states.size(); i++) Codec::encode(m_states[i], &words[i * Codec::WIDTH]);
+        out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(int32_t));
+    }
+
+    // Rebuilds the hash map from the stored states, so this costs as much as build()
+    void attach(const char* data, size_t size) {
+        uint64_t count;
+        if (size < sizeof(count)) throw std::runtime_error("indexer image too small");
+        std::memcpy(&count, data, sizeof(count));
+        if ((size - sizeof(count)) / sizeof(int32_t) / Codec::WIDTH < count) {
+            throw std::runtime_error("indexer image too small");
+        }
+
+        const auto* words = reinterpret_cast<const int32_t*>(data + sizeof(count));
+        std::vector<State> states(count);
+        for (size_t i = 0; i < count; i++) states[i] = Codec::decode(words + i * Codec::WIDTH);
+        build(states);
+        if (m_states.size() != count) throw std::runtime_error("indexer image repeats a state");
+    }
+};
+
+// Minimal perfect hash over a fixed state set (BBHash): each level is a bit array of
+// GAMMA bits per remaining state (SMALL_SET_GAMMA for small sets), and a state settles
+// in the first level where no other remaining state hashes to its bit. A state's id is
+// the rank of its bit across all levels, states left after MAX_LEVELS go to a small
+// fallback map. The flattened states are stored by id so lookups of states outside the
+// set return NOT_FOUND. attach() uses the levels, ranks and states of an image in
+// place; only the fallback map is rebuilt.
+template <typename State>
+class StateIndexer {
+   private:
+    using Codec = FlatCodec<State>;
+
+    // Bits per remaining state in each level. Sparser levels settle more states in the first
+    // level, which saves a level per lookup on average; small sets can afford that.
+    static constexpr double GAMMA = 2.0;
+    static constexpr double SMALL_SET_GAMMA = 8.0;
+    static constexpr size_t SMALL_SET_SIZE = size_t{1} << 16;
+    static constexpr int MAX_LEVELS = 24;
+
+    struct Level {
+        size_t bit_offset;  // first bit of this level in m_bits
+        uint64_t size;      // bits in this level, a multiple of 64
+    };
+
+    // Built by build(), or left empty when the arrays below point into an attached image
+    std::vector<Level> m_owned_levels;
+    std::vector<uint64_t> m_owned_bits;
+    std::vector<uint64_t> m_owned_ranks;
+    std::vector<int32_t> m_owned_keys;
+
+    const Level* m_levels = nullptr;
+    size_t m_level_count = 0;
+    const uint64_t* m_bits = nullptr;
+    size_t m_bit_words = 0;
+    const uint64_t* m_ranks = nullptr;  // set bits before each word of m_bits, m_bit_words + 1 entries
+    const int32_t* m_keys = nullptr;    // Codec::WIDTH words per id
+    std::unordered_map<State, size_t, StateHash<State>> m_fallback;
+    size_t m_size = 0;
+
+    // Image header, followed by the levels, bits, ranks, fallback ids and keys
+    struct ImageHeader {
+        uint64_t size;
+        uint64_t level_count;
+        uint64_t bit_words;
+        uint64_t fallback_count;
+    };
+
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // Words are folded in pairs by one multiply each and mixed once at the end
+    static uint64_t hash(const int32_t* words) {
+        uint64_t h = 0x9e3779b97f4a7c15ULL;
+        for (size_t i = 0; i < Codec::WIDTH; i += 2) {
+            uint64_t word = static_cast<uint32_t>(words[i]);
+            if (i + 1 < Codec::WIDTH) word |= static_cast<uint64_t>(static_cast<uint32_t>(words[i + 1])) << 32;
+            h = (h ^ word) * 0xbf58476d1ce4e5b9ULL;
+        }
+        return mix(h);
+    }
+
+    static uint64_t position(uint64_t h, int level, uint64_t size) {
+        uint64_t level_hash = (h ^ (level * 0x9e3779b97f4a7c15ULL)) * 0x94d049bb133111ebULL;
+        return indexer_detail::multiply_high(level_hash ^ (level_hash >> 31), size);
+    }
+
+    bool bit(size_t i) const { return (m_bits[i >> 6] >> (i & 63)) & 1; }
+
+    size_t rank(size_t i) const {
+        return m_ranks[i >> 6] + indexer_detail::popcount(m_bits[i >> 6] & ((1ULL << (i & 63)) - 1));
+    }
+
+    bool matches(size_t id, const int32_t* words) const {
+        const int32_t* key = m_keys + id * Codec::WIDTH;
+        for (size_t i = 0; i < Codec::WIDTH; i++) {
+            if (key[i] != words[i]) return false;
+        }
+        return true;
+    }
+
+    // Id of the state whose bit `words` hits, not yet checked against the stored state
+    size_t lookup(const int32_t* words, const State& s) const {
+        uint64_t h = hash(words);
+        for (size_t level = 0; level < m_level_count; level++) {
+            size_t i = m_levels[level].bit_offset + position(h, level, m_levels[level].size);
+            if (bit(i)) return rank(i);
+        }
+
+        auto it = m_fallback.find(s);
+        return it != m_fallback.end() ? it->second : NOT_FOUND;
+    }
+
+   public:
+    static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+    StateIndexer() = default;
+    // The views point into the owned arrays, which a move keeps but a copy would not
+    StateIndexer(const StateIndexer&) = delete;
+    StateIndexer& operator=(const StateIndexer&) = delete;
+    StateIndexer(StateIndexer&&) = default;
+    StateIndexer& operator=(StateIndexer&&) = default;
+
+    // A state listed more than once gets a single id, so size() counts distinct states
+    void build(const std::vector<State>& states) {
+        m_owned_levels.clear();
+        m_owned_bits.clear();
+        m_fallback.clear();
+
+        std::vector<uint64_t> hashes(states.size());
+        std::vector<int32_t> words(Codec::WIDTH);
+        for (size_t i = 0; i < states.size(); i++) {
+            Codec::encode(states[i], words.data());
+            hashes[i] = hash(words.data());
+        }
+
+        std::vector<size_t> remaining(states.size());
+        for (size_t i = 0; i < remaining.size(); i++) remaining[i] = i;
+
+        double gamma = states.size() <= SMALL_SET_SIZE ? SMALL_SET_GAMMA : GAMMA;
+        std::vector<uint64_t> seen, collided;
+        for (int level = 0; level < MAX_LEVELS && !remaining.empty(); level++) {
+            uint64_t size = ((static_cast<uint64_t>(gamma * remaining.size()) + 63) / 64) * 64;
+            seen.assign(size / 64, 0);
+            collided.assign(size / 64, 0);
+
+            for (size_t i : remaining) {
+                uint64_t p = position(hashes[i], level, size);
+                uint64_t mask = 1ULL << (p & 63);
+                if (seen[p >> 6] & mask) collided[p >> 6] |= mask;
+                seen[p >> 6] |= mask;
+            }
+
+            std::vector<size_t> next;
+            for (size_t i : remaining) {
+                uint64_t p = position(hashes[i], level, size);
+                if (collided[p >> 6] & (1ULL << (p & 63))) next.push_back(i);
+            }
+            for (size_t w = 0; w < seen.size(); w++) seen[w] &= ~collided[w];
+
+            m_owned_levels.push_back({m_owned_bits.size() * 64, size});
+            m_owned_bits.insert(m_owned_bits.end(), seen.begin(), seen.end());
+            remaining.swap(next);
+        }
+
+        m_owned_ranks.assign(m_owned_bits.size() + 1, 0);
+        for (size_t w = 0; w < m_owned_bits.size(); w++) {
+            m_owned_ranks[w + 1] = m_owned_ranks[w] + indexer_detail::popcount(m_owned_bits[w]);
+        }
+
+        // Copies of a state hash alike, collide on every level and end up here, where only the first is kept
+        size_t ranked = m_owned_ranks.back();
+        for (size_t i : remaining) m_fallback.emplace(states[i], ranked + m_fallback.size());
+
+        m_levels = m_owned_levels.data();
+        m_level_count = m_owned_levels.size();
+        m_bits = m_owned_bits.data();
+        m_bit_words = m_owned_bits.size();
+        m_ranks = m_owned_ranks.data();
+        m_size = ranked + m_fallback.size();
+
+        m_owned_keys.assign(m_size * Codec::WIDTH, 0);
+        for (const State& s : states) {
+            Codec::encode(s, words.data());
+            std::copy(words.begin(), words.end(), m_owned_keys.begin() + lookup(words.data(), s) * Codec::WIDTH);
+        }
+        m_keys = m_owned_keys.data();
+    }
+
+    void save(std::ostream& out) const {
+        ImageHeader header{m_size, m_level_count, m_bit_words, m_fallback.size()};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(m_levels), m_level_count * sizeof(Level));
+        out.write(reinterpret_cast<const char*>(m_bits), m_bit_words * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(m_ranks), (m_bit_words + 1) * sizeof(uint64_t));
+
+        std::vector<uint64_t> fallback_ids;
+        for (const auto& [s, id] : m_fallback) fallback_ids.push_back(id);
+        std::sort(fallback_ids.begin(), fallback_ids.end());
+        out.write(reinterpret_cast<const char*>(fallback_ids.data()), fallback_ids.size() * sizeof(uint64_t));
+
+        size_t key_words = m_size * Codec::WIDTH;
+        out.write(reinterpret_cast<const char*>(m_keys), key_words * sizeof(int32_t));
+        if (key_words % 2) {
+            int32_t padding = 0;
+            out.write(reinterpret_cast<const char*>(&padding), sizeof(padding));
+        }
+    }
+
+    // `data` must be 8-byte aligned and stay valid while the indexer is in use
+    void attach(const char* data, size_t size) {
+        ImageHeader header;
+        if (size < sizeof(header)) throw std::runtime_error("indexer image too small");
+        std::memcpy(&header, data, sizeof(header));
+
+        // Each count is bounded by the image size before any offset is computed from it
+        size_t words = (size - sizeof(header)) / sizeof(uint64_t);
+        if (header.level_count > MAX_LEVELS || header.bit_words >= words || header.fallback_count > words ||
+            header.size > words * 2 / Codec::WIDTH) {
+            throw std::runtime_error("indexer image too small");
+        }
+        size_t key_words = header.size * Codec::WIDTH;
+        size_t expected = sizeof(header) + header.level_count * sizeof(Level) +
+                          (2 * header.bit_words + 1 + header.fallback_count) * sizeof(uint64_t) +
+                          (key_words + key_words % 2) * sizeof(int32_t);
+        if (size != expected) throw std::runtime_error("indexer image has the wrong size");
+
+        const char* p = data + sizeof(header);
+        const auto* levels = reinterpret_cast<const Level*>(p);
+        p += header.level_count * sizeof(Level);
+        const auto* bits = reinterpret_cast<const uint64_t*>(p);
+        p += header.bit_words * sizeof(uint64_t);
+        const auto* ranks = reinterpret_cast<const uint64_t*>(p);
+        p += (header.bit_words + 1) * sizeof(uint64_t);
+        const auto* fallback_ids = reinterpret_cast<const uint64_t*>(p);
+        p += header.fallback_count * sizeof(uint64_t);
+        const auto* keys = reinterpret_cast<const int32_t*>(p);
+
+        for (size_t level = 0; level < header.level_count; level++) {
+            if (levels[level].bit_offset + levels[level].size > header.bit_words * 64) {
+                throw std::runtime_error("indexer level out of range");
+            }
+        }
+        if (ranks[header.bit_words] + header.fallback_count != header.size) {
+            throw std::runtime_error("indexer ranks do not match the state count");
+        }
+
+        std::unordered_map<State, size_t, StateHash<State>> fallback;
+        for (size_t i = 0; i < header.fallback_count; i++) {
+            if (fallback_ids[i] >= header.size) throw std::runtime_error("indexer fallback id out of range");
+            fallback.emplace(Codec::decode(keys + fallback_ids[i] * Codec::WIDTH), fallback_ids[i]);
+        }
+
+        m_owned_levels.clear();
+        m_owned_bits.clear();
+        m_owned_ranks.clear();
+        m_owned_keys.clear();
+        m_levels = levels;
+        m_level_count = header.level_count;
+        m_bits = bits;
+        m_bit_words = header.bit_words;
+        m_ranks = ranks;
+        m_keys = keys;
+        m_fallback = std::move(fallback);
+        m_size = header.size;
+    }
+
+    size_t index(const State& s) const {
+        int32_t words[Codec::WIDTH];
+        Codec::encode(s, words);
+        size_t id = lookup(words, s);
+        return id < m_size && matches(id, words) ? id : NOT_FOUND;
+    }
+
+    State state(size_t id) const { return Codec::decode(m_keys + id * Codec::WIDTH); }
+
+    size_t size() const { return m_size; }
+
+    // Bits per state of the hash itself, excluding the stored states
+    double bits_per_state() const {
+        return m_size ? 64.0 * (2 * m_bit_words + 1) / m_size : 0;
+    }
+};
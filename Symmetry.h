@@ -0,0 +1,78 @@
+#pragma once
+
+#include <tuple>
+#include <vector>
+
+#include "FunctionApproximator.h"
+#include "ValueStrategy.h"
+
+// Wrappers that look values up on a canonical representative of each state, so all
+// states related by an environment symmetry share one set of entries.
+//
+// Symmetry must provide
+//   std::pair<State, int> canonical(const State&) const  (representative and the transform g mapping s to it)
+//   Action apply(int g, const Action&) const               (the action as seen in the canonical frame)
+//   Action invert(int g, const Action&) const              (back from the canonical frame)
+
+template <typename State, typename Action, typename Inner, typename Symmetry>
+class SymmetricValueStrategy : public ValueStrategy<State, Action> {
+   protected:
+    Inner* m_inner;
+    Symmetry m_symmetry;
+
+   public:
+    SymmetricValueStrategy(Inner* inner, const Symmetry& symmetry) : m_inner(inner), m_symmetry(symmetry) {}
+
+    void initialize(MDP<State, Action>* mdp) override { m_inner->initialize(mdp); }
+
+    std::tuple<Action, Return> get_best_action(const State& s) override {
+        auto [canonical, g] = m_symmetry.canonical(s);
+        auto [action, value] = m_inner->get_best_action(canonical);
+        return {m_symmetry.invert(g, action), value};
+    }
+
+    Return Q(const State& s, const Action& a) const {
+        auto [canonical, g] = m_symmetry.canonical(s);
+        return m_inner->Q(canonical, m_symmetry.apply(g, a));
+    }
+
+    void set_q(const State& s, const Action& a, Return value) {
+        auto [canonical, g] = m_symmetry.canonical(s);
+        m_inner->set_q(canonical, m_symmetry.apply(g, a), value);
+    }
+
+    Inner* inner() { return m_inner; }
+
+    void save_state(StateWriter& writer) const { m_inner->save_state(writer); }
+    void load_state(StateReader& reader) { m_inner->load_state(reader); }
+};
+
+template <typename State, typename Action, typename Symmetry>
+class SymmetricApproximator : public FunctionApproximator<State, Action> {
+   protected:
+    FunctionApproximator<State, Action>* m_inner;
+    Symmetry m_symmetry;
+
+   public:
+    SymmetricApproximator(FunctionApproximator<State, Action>* inner, const Symmetry& symmetry)
+        : m_inner(inner), m_symmetry(symmetry) {}
+
+    double predict(const State& s, const Action& a) const override {
+        auto [canonical, g] = m_symmetry.canonical(s);
+        return m_inner->predict(canonical, m_symmetry.apply(g, a));
+    }
+
+    std::vector<double> gradient(const State& s, const Action& a) const override {
+        auto [canonical, g] = m_symmetry.canonical(s);
+        return m_inner->gradient(canonical, m_symmetry.apply(g, a));
+    }
+
+    void update(const State& s, const Action& a, double error, double step_size) override {
+        auto [canonical, g] = m_symmetry.canonical(s);
+        m_inner->update(canonical, m_symmetry.apply(g, a), error, step_size);
+    }
+
+    const std::vector<double>& get_weights() const override { return m_inner->get_weights(); }
+
+    void set_weights(const std::vector<double>& new_weights) override { m_inner->set_weights(new_weights); }
+};
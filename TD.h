@@ -1,15 +1,18 @@
 #pragma once
 
+#include <cmath>
 #include <limits>
 
 #include "GPI.h"
 #include "Policy.h"
+#include "StateActionTable.h"
+#include "StateArchive.h"
 #include "m_utils.h"
 
 template <typename State, typename Action, typename ValueStrategyType = TabularValueStrategy<State, Action>>
 class TD : public GPI<State, Action> {
    protected:
-    std::unordered_map<std::pair<State, Action>, int, StateActionPairHash<State, Action>> N;
+    StateActionTable<State, Action, int> N;  // visit counts, dense for indexed states
     const double step_size;
     ValueStrategyType* m_value_strategy;
 
@@ -20,12 +23,12 @@ class TD : public GPI<State, Action> {
           m_value_strategy(value_strategy),
           step_size(step_size) {
         policy->initialize(mdp_core, value_strategy);
+        N.initialize(*mdp_core);
     };
 
     void td_main() {
-        int i = 0;
-        do {  // episode loop
-            i++;
+        // m_policy_threshold represents the # of episodes before termination
+        while (this->m_episode < this->m_policy_threshold) {  // episode loop
             State s = this->m_mdp->reset();
             Action a = this->m_policy->sample(s);
             do {  // step loop
@@ -35,15 +38,84 @@ class TD : public GPI<State, Action> {
                         m_value_strategy->Q(s, a) + this->step_size * (r - m_value_strategy->Q(s, a)));
                 } else {
                     Action a_prime = this->m_policy->sample(s_prime);
+                    double discount = std::pow(this->m_discount_rate, this->m_mdp->step_duration());
                     m_value_strategy->set_q(s, a,
                         m_value_strategy->Q(s, a) +
-                        this->step_size * (r + this->m_discount_rate * m_value_strategy->Q(s_prime, a_prime) - m_value_strategy->Q(s, a)));
+                        this->step_size * (r + discount * m_value_strategy->Q(s_prime, a_prime) - m_value_strategy->Q(s, a)));
                     a = a_prime;
                 }
 
                 s = s_prime;
-            } while (!this->m_mdp->is_terminal(s));
-        } while (i < this->m_policy_threshold);  // m_policy_threshold represents the # of episodes before termination
+            } while (!this->m_mdp->is_terminal(s) && !this->m_mdp->truncated());
+            this->end_episode(++this->m_episode);
+        }
+    }
+
+    void policy_iteration() override { td_main(); }
+
+    // Everything td_main learns or draws from, for save_training_state/load_training_state
+    void save_state(StateWriter& writer) const {
+        writer.write(this->m_episode);
+        N.save_state(writer);
+        this->m_policy->save_state(writer);
+        m_value_strategy->save_state(writer);
+    }
+
+    void load_state(StateReader& reader) {
+        this->m_episode = reader.read<int>();
+        N.load_state(reader);
+        this->m_policy->load_state(reader);
+        m_value_strategy->load_state(reader);
+    }
+};
+
+// TD with the concrete environment, policy and value-strategy types known at compile
+// time: the step loop binds every call statically instead of going through MDP,
+// Policy and ValueStrategy virtuals, so it can be inlined.
+template <typename Env, typename PolicyType,
+          typename ValueStrategyType = TabularValueStrategy<typename Env::StateType, typename Env::ActionType>>
+class StaticTD : public TD<typename Env::StateType, typename Env::ActionType, ValueStrategyType> {
+   public:
+    using State = typename Env::StateType;
+    using Action = typename Env::ActionType;
+
+   protected:
+    Env* m_env;
+    PolicyType* m_typed_policy;
+
+    Action sample(const State& s) {
+        return m_typed_policy->sample_static(*m_env, s, [this](const State& state) {
+            return std::get<0>(this->m_value_strategy->ValueStrategyType::get_best_action(state));
+        });
+    }
+
+   public:
+    StaticTD(Env* env, PolicyType* policy, ValueStrategyType* value_strategy, const double discount_rate,
+             const long double policy_threshold, const double step_size)
+        : TD<State, Action, ValueStrategyType>(env, policy, value_strategy, discount_rate, policy_threshold, step_size),
+          m_env(env),
+          m_typed_policy(policy) {}
+
+    void td_main() {
+        ValueStrategyType& q = *this->m_value_strategy;
+        while (this->m_episode < this->m_policy_threshold) {  // episode loop
+            State s = m_env->Env::reset();
+            Action a = sample(s);
+            do {  // step loop
+                auto [s_prime, r] = m_env->Env::step(s, a);
+                if (m_env->Env::is_terminal(s_prime)) {
+                    q.set_q(s, a, q.Q(s, a) + this->step_size * (r - q.Q(s, a)));
+                } else {
+                    Action a_prime = sample(s_prime);
+                    double discount = std::pow(this->m_discount_rate, m_env->Env::step_duration());
+                    q.set_q(s, a, q.Q(s, a) + this->step_size * (r + discount * q.Q(s_prime, a_prime) - q.Q(s, a)));
+                    a = a_prime;
+                }
+
+                s = s_prime;
+            } while (!m_env->Env::is_terminal(s) && !m_env->Env::truncated());
+            this->end_episode(++this->m_episode);
+        }
     }
 
     void policy_iteration() override { td_main(); }
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Text encoding of states and actions for JSON keys and logs. Numbers are decimal,
+// bools true/false, pairs and tuples "(a, b, ...)", vectors "[a, b, ...]", nested
+// to any depth. The parser works in place with std::from_chars, accepts any of
+// ( [ { around a composite, tolerates missing spaces, and allows the outermost
+// brackets to be left out, so keys written by older versions still load.
+template <typename T, typename = void>
+struct TextCodec;
+
+namespace text_codec_detail {
+
+[[noreturn]] inline void fail(const char* at, const char* last, const char* expected) {
+    throw std::invalid_argument("Expected " + std::string(expected) + " at \"" + std::string(at, last) + "\"");
+}
+
+inline const char* skip_spaces(const char* first, const char* last) {
+    while (first != last && (*first == ' ' || *first == '\t' || *first == '\n')) first++;
+    return first;
+}
+
+inline char closing_bracket(char c) {
+    switch (c) {
+        case '(': return ')';
+        case '[': return ']';
+        case '{': return '}';
+        default: return '\0';
+    }
+}
+
+constexpr size_t VARIABLE_LENGTH = static_cast<size_t>(-1);
+
+// Parses "<open> e0, e1, ... <close>", or with `bare` the elements alone up to
+// `last`. parse_element(first, index) returns the end of element `index`. A
+// composite has `count` elements, or any number for VARIABLE_LENGTH.
+template <typename ParseElement>
+const char* parse_composite(const char* first, const char* last, bool bare, size_t count,
+                            ParseElement parse_element) {
+    first = skip_spaces(first, last);
+    char close = '\0';
+    if (!bare) {
+        close = first != last ? closing_bracket(*first) : '\0';
+        if (!close) fail(first, last, "'(', '[' or '{'");
+        first = skip_spaces(first + 1, last);
+    }
+
+    auto at_end = [&](const char* p) { return bare ? p == last : p != last && *p == close; };
+
+    size_t index = 0;
+    while (count == VARIABLE_LENGTH ? !at_end(first) : index < count) {
+        if (index > 0) {
+            if (first == last || *first != ',') fail(first, last, "','");
+            first = skip_spaces(first + 1, last);
+        }
+        first = skip_spaces(parse_element(first, index++), last);
+    }
+
+    if (!at_end(first)) fail(first, last, bare ? "end of key" : "closing bracket");
+    return bare ? first : first + 1;
+}
+
+}  // namespace text_codec_detail
+
+template <typename T>
+struct TextCodec<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>> {
+    static void encode(const T& value, std::string& out) {
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    static const char* decode(const char* first, const char* last, T& value, bool = false) {
+        first = text_codec_detail::skip_spaces(first, last);
+        auto result = std::from_chars(first, last, value);
+        if (result.ec != std::errc()) text_codec_detail::fail(first, last, "a number");
+        return result.ptr;
+    }
+};
+
+template <typename T>
+struct TextCodec<T, std::enable_if_t<std::is_enum_v<T>>> {
+    using Underlying = std::underlying_type_t<T>;
+
+    static void encode(const T& value, std::string& out) {
+        TextCodec<Underlying>::encode(static_cast<Underlying>(value), out);
+    }
+
+    static const char* decode(const char* first, const char* last, T& value, bool = false) {
+        Underlying underlying;
+        first = TextCodec<Underlying>::decode(first, last, underlying);
+        value = static_cast<T>(underlying);
+        return first;
+    }
+};
+
+template <>
+struct TextCodec<bool> {
+    static void encode(bool value, std::string& out) { out += value ? "true" : "false"; }
+
+    static const char* decode(const char* first, const char* last, bool& value, bool = false) {
+        first = text_codec_detail::skip_spaces(first, last);
+        // hit/stick: Blackjack actions (Action = bool) in Q files written before TextCodec
+        static constexpr std::pair<std::string_view, bool> WORDS[] = {
+            {"true", true}, {"false", false}, {"1", true}, {"0", false}, {"hit", true}, {"stick", false}};
+        std::string_view rest(first, last - first);
+        for (auto [word, meaning] : WORDS) {
+            if (rest.substr(0, word.size()) == word) {
+                value = meaning;
+                return first + word.size();
+            }
+        }
+        text_codec_detail::fail(first, last, "true, false, hit or stick");
+    }
+};
+
+template <typename... Ts>
+struct TextCodec<std::tuple<Ts...>> {
+    static void encode(const std::tuple<Ts...>& value, std::string& out) {
+        out += '(';
+        std::apply(
+            [&out](const Ts&... elements) {
+                size_t i = 0;
+                ((out += i++ ? ", " : "", TextCodec<Ts>::encode(elements, out)), ...);
+            },
+            value);
+        out += ')';
+    }
+
+    static const char* decode(const char* first, const char* last, std::tuple<Ts...>& value, bool bare = false) {
+        return text_codec_detail::parse_composite(first, last, bare, sizeof...(Ts), [&](const char* p, size_t index) {
+            return decode_element(p, last, value, index);
+        });
+    }
+
+   private:
+    template <size_t I = 0>
+    static const char* decode_element(const char* first, const char* last, std::tuple<Ts...>& value, size_t index) {
+        if constexpr (I < sizeof...(Ts)) {
+            using Element = std::tuple_element_t<I, std::tuple<Ts...>>;
+            if (index == I) return TextCodec<Element>::decode(first, last, std::get<I>(value));
+            return decode_element<I + 1>(first, last, value, index);
+        }
+        return first;
+    }
+};
+
+template <typename A, typename B>
+struct TextCodec<std::pair<A, B>> {
+    static void encode(const std::pair<A, B>& value, std::string& out) {
+        out += '(';
+        TextCodec<A>::encode(value.first, out);
+        out += ", ";
+        TextCodec<B>::encode(value.second, out);
+        out += ')';
+    }
+
+    static const char* decode(const char* first, const char* last, std::pair<A, B>& value, bool bare = false) {
+        return text_codec_detail::parse_composite(first, last, bare, 2, [&](const char* p, size_t index) {
+            return index == 0 ? TextCodec<A>::decode(p, last, value.first) : TextCodec<B>::decode(p, last, value.second);
+        });
+    }
+};
+
+template <typename T>
+struct TextCodec<std::vector<T>> {
+    static void encode(const std::vector<T>& value, std::string& out) {
+        out += '[';
+        for (size_t i = 0; i < value.size(); i++) {
+            if (i > 0) out += ", ";
+            TextCodec<T>::encode(value[i], out);
+        }
+        out += ']';
+    }
+
+    static const char* decode(const char* first, const char* last, std::vector<T>& value, bool bare = false) {
+        value.clear();
+        return text_codec_detail::parse_composite(
+            first, last, bare, text_codec_detail::VARIABLE_LENGTH, [&](const char* p, size_t) {
+                T element;
+                p = TextCodec<T>::decode(p, last, element);
+                value.push_back(std::move(element));
+                return p;
+            });
+    }
+};
+
+template <typename T>
+std::string to_text(const T& value) {
+    std::string out;
+    TextCodec<T>::encode(value, out);
+    return out;
+}
+
+template <typename T>
+void to_text(const T& value, std::string& out) {
+    out.clear();
+    TextCodec<T>::encode(value, out);
+}
+
+// Parses the whole of `text`, retrying without outermost brackets (as in
+// "(1, 2), (3, 4)") if that fails. Throws std::invalid_argument on malformed input.
+template <typename T>
+T from_text(std::string_view text) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    T value;
+    auto parse = [&](bool bare) {
+        const char* end = text_codec_detail::skip_spaces(TextCodec<T>::decode(first, last, value, bare), last);
+        if (end != last) text_codec_detail::fail(end, last, "end of key");
+    };
+
+    try {
+        parse(false);
+    } catch (const std::invalid_argument& error) {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+            throw;
+        } else {
+            try {
+                parse(true);
+            } catch (const std::invalid_argument&) {
+                throw error;
+            }
+        }
+    }
+    return value;
+}
@@ -0,0 +1,444 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+#include "StateCodec.h"
+#include "m_types.h"
+#include "m_utils.h"
+
+// Columnar trajectory files of (state, action, reward, next state, done, episode,
+// ticks) transitions, for analysis and offline training:
+//
+//   header | chunk | chunk | ...
+//   chunk: chunk header | episode: rows x uint64 | reward: rows x Return | ticks: rows x uint32
+//          | state, next state: rows x StateCodec::WIDTH int32 words each
+//          | action: rows x ActionCodec::WIDTH int32 words | done: rows x uint8 | padding to 8 bytes
+//
+// in native endianness. The codecs default to FlatCodec; a PackedCodec stores a
+// bounded state in one or two words instead of one word per field, and the file
+// records which codecs wrote it. Each column of a chunk is contiguous, so a scan
+// over one field touches only that field. Every chunk carries its row count and
+// an FNV-1a checksum; a reader stops at the first incomplete or damaged chunk, so
+// a file cut short by a crash still yields every chunk written before it. `ticks`
+// is the number of primitive time steps a transition spanned (MDP::step_duration),
+// so offline targets can discount a repeated action by gamma^ticks.
+
+namespace trajectory_detail {
+
+constexpr char MAGIC[4] = {'R', 'L', 'T', 'R'};
+constexpr uint32_t VERSION = 2;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t state_width;
+    uint32_t action_width;
+    uint64_t signature;
+};
+
+struct ChunkHeader {
+    uint64_t rows;
+    uint64_t checksum;
+};
+
+template <typename StateCodec, typename ActionCodec>
+uint64_t signature() {
+    std::string description = StateCodec::signature() + "," + ActionCodec::signature() + "->f" +
+                              std::to_string(8 * sizeof(Return));
+    uint64_t hash = FNV_OFFSET;
+    for (unsigned char c : description) hash = (hash ^ c) * FNV_PRIME;
+    return hash;
+}
+
+template <typename StateCodec, typename ActionCodec>
+constexpr size_t row_size() {
+    return sizeof(uint64_t) + sizeof(Return) + sizeof(uint32_t) +
+           (2 * StateCodec::WIDTH + ActionCodec::WIDTH) * sizeof(int32_t) + 1;
+}
+
+template <typename StateCodec, typename ActionCodec>
+size_t chunk_size(size_t rows) {
+    return (rows * row_size<StateCodec, ActionCodec>() + 7) / 8 * 8;
+}
+
+// Whether a chunk header's row count can describe a chunk within `available` bytes.
+// Checked before chunk_size, which a damaged row count could overflow.
+template <typename StateCodec, typename ActionCodec>
+bool rows_fit(uint64_t rows, size_t available) {
+    return rows > 0 && rows <= available / row_size<StateCodec, ActionCodec>();
+}
+
+}  // namespace trajectory_detail
+
+// Appends transitions from the training thread and writes them on a background
+// thread. record() only encodes into the current chunk; full chunks are handed to
+// the writer, and their buffers come back for reuse. If the disk falls more than
+// MAX_PENDING chunks behind, record() waits rather than buffer without bound.
+template <typename State, typename Action, typename StateCodec = FlatCodec<State>,
+          typename ActionCodec = FlatCodec<Action>>
+class TrajectoryRecorder {
+   private:
+    static constexpr size_t MAX_PENDING = 4;
+
+    struct Chunk {
+        std::vector<uint64_t> episodes;
+        std::vector<Return> rewards;
+        std::vector<uint32_t> ticks;
+        std::vector<int32_t> states;
+        std::vector<int32_t> next_states;
+        std::vector<int32_t> actions;
+        std::vector<uint8_t> done;
+
+        size_t size() const { return rewards.size(); }
+
+        void clear() {
+            episodes.clear();
+            rewards.clear();
+            ticks.clear();
+            states.clear();
+            next_states.clear();
+            actions.clear();
+            done.clear();
+        }
+    };
+
+    std::ofstream m_file;
+    std::string m_file_path;
+    size_t m_file_size{0};       // bytes written by the writer thread
+    size_t m_submitted_size{0};  // bytes the file will have once every submitted chunk is written
+    size_t m_chunk_rows;
+    std::vector<char> m_bytes;  // writer thread's encoding buffer
+    Chunk m_current;
+    size_t m_recorded{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Chunk> m_pending;
+    std::vector<Chunk> m_free;
+    bool m_writing{false};
+    bool m_stop{false};
+    bool m_failed{false};
+    std::thread m_thread;
+
+    void write_chunk(const Chunk& chunk) {
+        using namespace trajectory_detail;
+        std::vector<char>& bytes = m_bytes;
+        bytes.assign(sizeof(ChunkHeader) + chunk_size<StateCodec, ActionCodec>(chunk.size()), 0);
+        char* out = bytes.data() + sizeof(ChunkHeader);
+        auto append = [&out](const auto& column) {
+            size_t size = column.size() * sizeof(column[0]);
+            std::memcpy(out, column.data(), size);
+            out += size;
+        };
+        append(chunk.episodes);
+        append(chunk.rewards);
+        append(chunk.ticks);
+        append(chunk.states);
+        append(chunk.next_states);
+        append(chunk.actions);
+        append(chunk.done);
+
+        ChunkHeader header{chunk.size(), 0};
+        header.checksum =
+            fnv1a(FNV_OFFSET, bytes.data() + sizeof(ChunkHeader), bytes.size() - sizeof(ChunkHeader));
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        m_file.write(bytes.data(), bytes.size());
+        m_file.flush();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file_size += bytes.size();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cv.wait(lock, [this] { return !m_pending.empty() || m_stop; });
+            if (m_pending.empty()) return;
+
+            Chunk chunk = std::move(m_pending.front());
+            m_pending.pop_front();
+            m_writing = true;
+            lock.unlock();
+
+            write_chunk(chunk);
+            chunk.clear();
+
+            lock.lock();
+            if (!m_file && !m_failed) {
+                std::cerr << "Failed to write trajectories to " << m_file_path << std::endl;
+                m_failed = true;
+            }
+            m_free.push_back(std::move(chunk));
+            m_writing = false;
+            m_cv.notify_all();
+        }
+    }
+
+    void submit() {
+        using namespace trajectory_detail;
+        if (m_current.size() == 0) return;
+        m_submitted_size += sizeof(ChunkHeader) + chunk_size<StateCodec, ActionCodec>(m_current.size());
+        Chunk next;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_pending.size() < MAX_PENDING; });
+            m_pending.push_back(std::move(m_current));
+            if (!m_free.empty()) {
+                next = std::move(m_free.back());
+                m_free.pop_back();
+            }
+        }
+        m_cv.notify_all();
+        m_current = std::move(next);
+        reserve(m_current);
+    }
+
+    void reserve(Chunk& chunk) {
+        chunk.episodes.reserve(m_chunk_rows);
+        chunk.rewards.reserve(m_chunk_rows);
+        chunk.ticks.reserve(m_chunk_rows);
+        chunk.states.reserve(m_chunk_rows * StateCodec::WIDTH);
+        chunk.next_states.reserve(m_chunk_rows * StateCodec::WIDTH);
+        chunk.actions.reserve(m_chunk_rows * ActionCodec::WIDTH);
+        chunk.done.reserve(m_chunk_rows);
+    }
+
+    // Keeps the complete chunks of an existing file of the same types and drops any torn tail
+    bool open_for_append(const std::string& full_path) {
+        using namespace trajectory_detail;
+        if (!std::filesystem::exists(full_path) || std::filesystem::file_size(full_path) < sizeof(Header)) {
+            return false;
+        }
+
+        size_t valid_size;
+        try {
+            MappedFile file(full_path);
+            Header header;
+            std::memcpy(&header, file.data(), sizeof(header));
+            if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+                header.signature != signature<StateCodec, ActionCodec>()) {
+                throw std::runtime_error("not a trajectory file of these state and action types");
+            }
+            valid_size = sizeof(Header);
+            while (valid_size + sizeof(ChunkHeader) <= file.size()) {
+                ChunkHeader chunk;
+                std::memcpy(&chunk, file.data() + valid_size, sizeof(chunk));
+                if (!rows_fit<StateCodec, ActionCodec>(chunk.rows, file.size() - valid_size - sizeof(ChunkHeader))) {
+                    break;
+                }
+                size_t size = chunk_size<StateCodec, ActionCodec>(chunk.rows);
+                const char* data = file.data() + valid_size + sizeof(ChunkHeader);
+                if (valid_size + sizeof(ChunkHeader) + size > file.size() ||
+                    fnv1a(FNV_OFFSET, data, size) != chunk.checksum) {
+                    break;
+                }
+                valid_size += sizeof(ChunkHeader) + size;
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Cannot append to " + full_path + ": " + e.what());
+        }
+
+        std::filesystem::resize_file(full_path, valid_size);
+        m_file.open(full_path, std::ios::binary | std::ios::in | std::ios::out);
+        m_file.seekp(0, std::ios::end);
+        m_file_size = valid_size;
+        m_submitted_size = valid_size;
+        return true;
+    }
+
+   public:
+    // Creates output_dir + file_path, or with `append` continues an existing file of the same types
+    TrajectoryRecorder(const std::string& file_path, bool append = false, size_t chunk_rows = 1 << 16)
+        : m_file_path(file_path), m_chunk_rows(chunk_rows) {
+        using namespace trajectory_detail;
+        std::string full_path = output_dir + file_path;
+        if (!(append && open_for_append(full_path))) {
+            m_file.open(full_path, std::ios::binary | std::ios::trunc);
+            Header header{};
+            std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.state_width = StateCodec::WIDTH;
+            header.action_width = ActionCodec::WIDTH;
+            header.signature = signature<StateCodec, ActionCodec>();
+            m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            m_file_size = sizeof(header);
+            m_submitted_size = sizeof(header);
+        }
+        if (!m_file) {
+            throw std::runtime_error("Failed to open file for writing trajectories: " + file_path);
+        }
+
+        reserve(m_current);
+        m_thread = std::thread(&TrajectoryRecorder::run, this);
+    }
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    // Writes everything recorded so far, then stops the writer thread
+    ~TrajectoryRecorder() {
+        submit();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    void record(const State& s, const Action& a, Return reward, const State& next_state, bool done,
+                uint64_t episode, TimeStep ticks = 1) {
+        Chunk& chunk = m_current;
+        chunk.episodes.push_back(episode);
+        chunk.rewards.push_back(reward);
+        chunk.ticks.push_back(ticks);
+        chunk.states.resize(chunk.states.size() + StateCodec::WIDTH);
+        StateCodec::encode(s, chunk.states.data() + chunk.states.size() - StateCodec::WIDTH);
+        chunk.next_states.resize(chunk.next_states.size() + StateCodec::WIDTH);
+        StateCodec::encode(next_state, chunk.next_states.data() + chunk.next_states.size() - StateCodec::WIDTH);
+        chunk.actions.resize(chunk.actions.size() + ActionCodec::WIDTH);
+        ActionCodec::encode(a, chunk.actions.data() + chunk.actions.size() - ActionCodec::WIDTH);
+        chunk.done.push_back(done);
+        m_recorded++;
+
+        if (chunk.size() == m_chunk_rows) submit();
+    }
+
+    // Hands the partial chunk to the writer and waits until everything is on disk
+    void flush() {
+        submit();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_pending.empty() && !m_writing; });
+    }
+
+    size_t recorded() const { return m_recorded; }
+
+    // Length the file will have once everything recorded so far is on disk. The
+    // partial chunk is handed to the writer so the length ends on a chunk, but
+    // nothing waits for the disk.
+    size_t file_size() {
+        submit();
+        return m_submitted_size;
+    }
+
+    // Drops everything after the first `size` bytes, which must be a length
+    // returned by file_size(), e.g. the transitions recorded after the training
+    // state a run resumes from. Returns false if the file is shorter than that.
+    bool truncate(size_t size) {
+        flush();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (size > m_file_size) return false;
+        m_file.flush();
+        std::filesystem::resize_file(output_dir + m_file_path, size);
+        m_file.seekp(size);
+        m_file_size = size;
+        m_submitted_size = size;
+        return static_cast<bool>(m_file);
+    }
+};
+
+// Memory-mapped view of a trajectory file. Chunks are located when the file is
+// opened; their columns are read in place.
+template <typename State, typename Action, typename StateCodec = FlatCodec<State>,
+          typename ActionCodec = FlatCodec<Action>>
+class TrajectoryReader {
+   public:
+    class Chunk {
+       private:
+        size_t m_rows;
+        const char* m_data;
+
+        const int32_t* words(size_t offset) const { return reinterpret_cast<const int32_t*>(m_data + offset); }
+        size_t ticks_offset() const { return m_rows * (sizeof(uint64_t) + sizeof(Return)); }
+        size_t states_offset() const { return ticks_offset() + m_rows * sizeof(uint32_t); }
+        size_t next_states_offset() const { return states_offset() + m_rows * StateCodec::WIDTH * sizeof(int32_t); }
+        size_t actions_offset() const { return next_states_offset() + m_rows * StateCodec::WIDTH * sizeof(int32_t); }
+        size_t done_offset() const { return actions_offset() + m_rows * ActionCodec::WIDTH * sizeof(int32_t); }
+
+       public:
+        Chunk(size_t rows, const char* data) : m_rows(rows), m_data(data) {}
+
+        size_t size() const { return m_rows; }
+        const uint64_t* episodes() const { return reinterpret_cast<const uint64_t*>(m_data); }
+        const Return* rewards() const {
+            return reinterpret_cast<const Return*>(m_data + m_rows * sizeof(uint64_t));
+        }
+        const uint32_t* ticks() const { return reinterpret_cast<const uint32_t*>(m_data + ticks_offset()); }
+        const uint8_t* done() const { return reinterpret_cast<const uint8_t*>(m_data + done_offset()); }
+
+        State state(size_t i) const { return StateCodec::decode(words(states_offset()) + i * StateCodec::WIDTH); }
+        State next_state(size_t i) const {
+            return StateCodec::decode(words(next_states_offset()) + i * StateCodec::WIDTH);
+        }
+        Action action(size_t i) const {
+            return ActionCodec::decode(words(actions_offset()) + i * ActionCodec::WIDTH);
+        }
+    };
+
+   private:
+    MappedFile m_file;
+    std::vector<Chunk> m_chunks;
+    size_t m_size{0};
+
+   public:
+    // Throws std::runtime_error if the file is not a trajectory file of these types.
+    // Reading stops at the first chunk that is incomplete or fails its checksum.
+    explicit TrajectoryReader(const std::string& file_path, bool verify_checksums = true) : m_file(file_path) {
+        using namespace trajectory_detail;
+
+        Header header;
+        if (m_file.size() < sizeof(header)) throw std::runtime_error("file too small");
+        std::memcpy(&header, m_file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            throw std::runtime_error("not a trajectory file of version " + std::to_string(VERSION));
+        }
+        if (header.state_width != StateCodec::WIDTH || header.action_width != ActionCodec::WIDTH ||
+            header.signature != signature<StateCodec, ActionCodec>()) {
+            throw std::runtime_error("state or action type does not match the file");
+        }
+
+        size_t offset = sizeof(Header);
+        while (offset + sizeof(ChunkHeader) <= m_file.size()) {
+            ChunkHeader chunk;
+            std::memcpy(&chunk, m_file.data() + offset, sizeof(chunk));
+            if (!rows_fit<StateCodec, ActionCodec>(chunk.rows, m_file.size() - offset - sizeof(ChunkHeader))) break;
+            const char* data = m_file.data() + offset + sizeof(ChunkHeader);
+            size_t size = chunk_size<StateCodec, ActionCodec>(chunk.rows);
+            if (offset + sizeof(ChunkHeader) + size > m_file.size()) break;
+            if (verify_checksums && fnv1a(FNV_OFFSET, data, size) != chunk.checksum) break;
+
+            m_chunks.emplace_back(chunk.rows, data);
+            m_size += chunk.rows;
+            offset += sizeof(ChunkHeader) + size;
+        }
+    }
+
+    const std::vector<Chunk>& chunks() const { return m_chunks; }
+    // Number of transitions in all readable chunks
+    size_t size() const { return m_size; }
+
+    // Calls f(s, a, reward, next_state, done, episode) for every transition in file order
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const Chunk& chunk : m_chunks) {
+            const uint64_t* episodes = chunk.episodes();
+            const Return* rewards = chunk.rewards();
+            const uint8_t* done = chunk.done();
+            for (size_t i = 0; i < chunk.size(); i++) {
+                f(chunk.state(i), chunk.action(i), rewards[i], chunk.next_state(i), done[i] != 0, episodes[i]);
+            }
+        }
+    }
+};
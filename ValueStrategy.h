@@ -1,7 +1,11 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 #include "MDP.h"
+#include "StateActionTable.h"
+#include "StateArchive.h"
+#include "StateCodec.h"
 
 template <typename State, typename Action>
 class ValueStrategy {
@@ -21,24 +25,53 @@ class TabularValueStrategy : public ValueStrategy<State, Action> {
     MDP<State, Action>* m_mdp;
     bool m_strict{false};
 
+    // Incremental greedy mode: argmax action and max Q per state, kept current by set_q. An entry
+    // goes stale when its maximum decreases and is rescanned on the next get_best_action.
+    struct GreedyEntry {
+        std::tuple<Action, Return> best;
+        bool stale;
+    };
+    bool m_incremental_greedy{false};
+    std::unordered_map<State, GreedyEntry, StateHash<State>> m_greedy{};
+
+    std::tuple<Action, Return> scan_best_action(const State& s) const {
+        Return max_return = std::numeric_limits<Return>::lowest();
+        Action maximizing_action;
+
+        for (const Action& a : m_mdp->actions(s)) {
+            Return candidate_return = Q(s, a);
+            if (candidate_return > max_return) {
+                max_return = candidate_return;
+                maximizing_action = a;
+            }
+        }
+
+        return {maximizing_action, max_return};
+    }
+
    public:
     TabularValueStrategy() : m_mdp(nullptr) {}
 
     void set_strict_mode(bool strict) { m_strict = strict; }
 
+    void set_incremental_greedy(bool incremental) {
+        m_incremental_greedy = incremental;
+        m_greedy.clear();
+    }
+
     void initialize(MDP<State, Action>* mdp) override {
         m_mdp = mdp;
 
-        for (const State& s : m_mdp->S()) {
+        for (const State& s : m_mdp->states()) {
             m_v[s] = 0;
-            for (const Action& a : m_mdp->A(s)) {
+            for (const Action& a : m_mdp->actions(s)) {
                 m_Q[{s, a}] = 0;
             }
         }
 
-        for (const State& s : m_mdp->T()) {
+        for (const State& s : m_mdp->terminals()) {
             m_v[s] = 0;
-            for (const Action& a : m_mdp->A(s)) {
+            for (const Action& a : m_mdp->actions(s)) {
                 m_Q[{s, a}] = 0;
             }
         }
@@ -49,18 +82,16 @@ class TabularValueStrategy : public ValueStrategy<State, Action> {
             throw std::logic_error("TabularValueStrategy not initialized with an MDP");
         }
 
-        Return max_return = std::numeric_limits<Return>::lowest();
-        Action maximizing_action;
-
-        for (const Action& a : m_mdp->A(s)) {
-            Return candidate_return = Q(s, a);
-            if (candidate_return > max_return) {
-                max_return = candidate_return;
-                maximizing_action = a;
-            }
+        if (!m_incremental_greedy) {
+            return scan_best_action(s);
         }
 
-        return {maximizing_action, max_return};
+        GreedyEntry& entry = m_greedy.try_emplace(s, GreedyEntry{{}, true}).first->second;
+        if (entry.stale) {
+            entry.best = scan_best_action(s);
+            entry.stale = false;
+        }
+        return entry.best;
     }
 
     Return v(const State& s) const {
@@ -83,11 +114,178 @@ class TabularValueStrategy : public ValueStrategy<State, Action> {
 
     void set_v(const State& s, Return value) { m_v[s] = value; }
 
-    void set_q(const State& s, const Action& a, Return value) { m_Q[{s, a}] = value; }
+    void set_q(const State& s, const Action& a, Return value) {
+        m_Q[{s, a}] = value;
+
+        if (m_incremental_greedy) {
+            auto it = m_greedy.find(s);
+            if (it == m_greedy.end() || it->second.stale) return;
+
+            auto& [best_action, best_value] = it->second.best;
+            if (value > best_value) {
+                best_action = a;
+                best_value = value;
+            } else if (a == best_action && value < best_value) {
+                it->second.stale = true;
+            }
+        }
+    }
 
     std::unordered_map<State, Return, StateHash<State>>& get_v() { return m_v; }
 
-    std::unordered_map<std::pair<State, Action>, Return, StateActionPairHash<State, Action>>& get_Q() { return m_Q; }
+    const std::unordered_map<std::pair<State, Action>, Return, StateActionPairHash<State, Action>>& get_Q() const {
+        return m_Q;
+    }
+    // Writes through this reference bypass set_q, so the incremental greedy entries are dropped
+    std::unordered_map<std::pair<State, Action>, Return, StateActionPairHash<State, Action>>& mutable_Q() {
+        m_greedy.clear();
+        return m_Q;
+    }
+
+    void save_state(StateWriter& writer) const {
+        writer.write_map(m_v);
+        writer.write_map(m_Q);
+    }
+
+    void load_state(StateReader& reader) {
+        reader.read_map(m_v);
+        reader.read_map(m_Q);
+        m_greedy.clear();
+    }
+};
+
+// Tabular Q in a StateActionTable: environments that call MDP::index_states() get dense rows,
+// so get_best_action looks its state up once and scans the row instead of hashing every
+// (state, action) pair. States outside the index are kept in a map, as TabularValueStrategy does.
+template <typename State, typename Action>
+class IndexedTabularValueStrategy : public ValueStrategy<State, Action> {
+   protected:
+    StateActionTable<State, Action, Return> m_Q;
+    MDP<State, Action>* m_mdp;
+
+   public:
+    IndexedTabularValueStrategy() : m_mdp(nullptr) {}
+
+    void initialize(MDP<State, Action>* mdp) override {
+        m_mdp = mdp;
+        m_Q.initialize(*mdp);
+    }
+
+    std::tuple<Action, Return> get_best_action(const State& s) override {
+        if (!m_mdp) {
+            throw std::logic_error("IndexedTabularValueStrategy not initialized with an MDP");
+        }
+
+        Return max_return = std::numeric_limits<Return>::lowest();
+        Action maximizing_action;
+
+        size_t row = m_Q.row(s);
+        if (row != m_Q.NOT_FOUND) {
+            for (size_t i = m_Q.row_begin(row); i < m_Q.row_end(row); i++) {
+                if (m_Q.value(i) > max_return) {
+                    max_return = m_Q.value(i);
+                    maximizing_action = m_Q.action(i);
+                }
+            }
+            return {maximizing_action, max_return};
+        }
+
+        for (const Action& a : m_mdp->actions(s)) {
+            Return candidate_return = Q(s, a);
+            if (candidate_return > max_return) {
+                max_return = candidate_return;
+                maximizing_action = a;
+            }
+        }
+
+        return {maximizing_action, max_return};
+    }
+
+    Return Q(const State& s, const Action& a) const { return m_Q.get(s, a); }
+
+    void set_q(const State& s, const Action& a, Return value) { m_Q[{s, a}] = value; }
+
+    const StateActionTable<State, Action, Return>& get_Q() const { return m_Q; }
+
+    void save_state(StateWriter& writer) const { m_Q.save_state(writer); }
+
+    void load_state(StateReader& reader) { m_Q.load_state(reader); }
+};
+
+// Tabular Q keyed on the packed form of (state, action): StateCodec and ActionCodec are
+// PackedCodecs whose bits fit in one uint64_t together, so no state or action is copied
+// into the table.
+template <typename State, typename Action, typename StateCodec, typename ActionCodec>
+class PackedTabularValueStrategy : public ValueStrategy<State, Action> {
+    static_assert(StateCodec::BITS + ActionCodec::BITS <= 64, "Packed state and action do not fit in 64 bits");
+
+   protected:
+    std::unordered_map<uint64_t, Return> m_Q{};
+    MDP<State, Action>* m_mdp;
+
+   public:
+    PackedTabularValueStrategy() : m_mdp(nullptr) {}
+
+    static uint64_t pack(const State& s, const Action& a) {
+        return (StateCodec::encode(s) << ActionCodec::BITS) | ActionCodec::encode(a);
+    }
+
+    static std::pair<State, Action> unpack(uint64_t key) {
+        uint64_t action_mask = ActionCodec::BITS == 64 ? ~uint64_t{0} : (uint64_t{1} << ActionCodec::BITS) - 1;
+        return {StateCodec::decode(key >> ActionCodec::BITS), ActionCodec::decode(key & action_mask)};
+    }
+
+    void initialize(MDP<State, Action>* mdp) override { m_mdp = mdp; }
+
+    std::tuple<Action, Return> get_best_action(const State& s) override {
+        if (!m_mdp) {
+            throw std::logic_error("PackedTabularValueStrategy not initialized with an MDP");
+        }
+
+        Return max_return = std::numeric_limits<Return>::lowest();
+        Action maximizing_action;
+
+        for (const Action& a : m_mdp->actions(s)) {
+            Return candidate_return = Q(s, a);
+            if (candidate_return > max_return) {
+                max_return = candidate_return;
+                maximizing_action = a;
+            }
+        }
+
+        return {maximizing_action, max_return};
+    }
+
+    Return Q(const State& s, const Action& a) const {
+        auto it = m_Q.find(pack(s, a));
+        return it != m_Q.end() ? it->second : 0;
+    }
+
+    void set_q(const State& s, const Action& a, Return value) { m_Q[pack(s, a)] = value; }
+
+    size_t size() const { return m_Q.size(); }
+
+    std::unordered_map<uint64_t, Return>& get_Q() { return m_Q; }
+    const std::unordered_map<uint64_t, Return>& get_Q() const { return m_Q; }
+
+    // Packed keys are 64 bits wide, wider than a FlatCodec word, so entries go as (key, value) pairs
+    void save_state(StateWriter& writer) const {
+        writer.write<uint64_t>(m_Q.size());
+        for (const auto& [key, value] : m_Q) {
+            writer.write(key);
+            writer.write(value);
+        }
+    }
+
+    void load_state(StateReader& reader) {
+        size_t size = reader.read<uint64_t>();
+        m_Q.clear();
+        m_Q.reserve(size);
+        for (size_t i = 0; i < size; i++) {
+            uint64_t key = reader.read<uint64_t>();
+            m_Q.emplace(key, reader.read<Return>());
+        }
+    }
 };
 
 template <typename State, typename Action>
@@ -121,20 +319,43 @@ class ApproximationValueStrategy : public ValueStrategy<State, Action> {
         double best_value = std::numeric_limits<double>::lowest();
 
         // Always use all_possible_actions for function approximation
-        static int i = 0;
-        i++;
-        auto all_actions = m_mdp->all_possible_actions();
-        for (Action a : all_actions) {
+        const auto& actions = m_mdp->all_actions();
+        const auto* mask = m_mdp->action_mask(s);
+        for (size_t i = 0; i < actions.size(); i++) {
             // Skip invalid actions for this state
-            if (!m_mdp->is_valid(s, a)) {
+            if (mask ? !(*mask)[i] : !m_mdp->is_valid(s, actions[i])) {
                 continue;
             }
 
-            double value = m_approximator->predict(s, a);
+            double value = m_approximator->predict(s, actions[i]);
 
             if (value > best_value) {
                 best_value = value;
-                best_action = a;
+                best_action = actions[i];
+            }
+        }
+
+        return {best_action, best_value};
+    }
+
+    // get_best_action with the environment and approximator types known at compile time
+    template <typename Env, typename Approximator>
+    std::tuple<Action, Return> get_best_action_static(Env& env, Approximator& approximator, const State& s) {
+        Action best_action;
+        double best_value = std::numeric_limits<double>::lowest();
+
+        const auto& actions = env.Env::all_actions();
+        const auto* mask = env.Env::action_mask(s);
+        for (size_t i = 0; i < actions.size(); i++) {
+            if (mask ? !(*mask)[i] : !env.Env::is_valid(s, actions[i])) {
+                continue;
+            }
+
+            double value = approximator.Approximator::predict(s, actions[i]);
+
+            if (value > best_value) {
+                best_value = value;
+                best_action = actions[i];
             }
         }
 
@@ -144,4 +365,12 @@ class ApproximationValueStrategy : public ValueStrategy<State, Action> {
     double Q(const State& s, const Action& a) const { return m_approximator->predict(s, a); }
 
     FunctionApproximator<State, Action>* get_approximator() const { return m_approximator; }
+
+    void save_state(StateWriter& writer) const { writer.write_vector(m_approximator->get_weights()); }
+
+    void load_state(StateReader& reader) {
+        std::vector<double> weights;
+        reader.read_vector(weights);
+        m_approximator->set_weights(weights);
+    }
 };
\ No newline at end of file
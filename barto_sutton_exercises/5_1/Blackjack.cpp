@@ -18,6 +18,7 @@ void Blackjack::initialize() {
             }
         }
     }
+    index_states();
 }
 
 int Blackjack::draw_card() { return random_value(ACE, FACE_CARD); }
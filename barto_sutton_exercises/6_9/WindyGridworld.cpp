@@ -14,12 +14,13 @@ void WindyGridworld::initialize() {
             }
         }
     }
+    set_terminals({terminal_state});
+    publish_action_masks();
+    index_states();
 
     int a = 5;
 }
 
-bool WindyGridworld::is_terminal(const State& s) { return s == terminal_state; }
-
 State WindyGridworld::reset() { return initial_state; }
 
 std::pair<State, Reward> WindyGridworld::step(const State& state, const Action& action) {
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "MDPWrappers.h"
+#include "OfflineSolver.h"
+#include "Policy.h"
+#include "TrajectoryRecorder.h"
+#include "ValueStrategy.h"
+#include "WindyGridworld.h"
+#include "serialization.h"
+
+// Records random play, then learns Q from the recording alone with fitted Q
+// iteration. The shortest path from the start takes 15 moves (Sutton & Barto,
+// Example 6.5), so the start state's learned value is known in advance.
+static constexpr int N_OF_EPISODES = 50;
+static constexpr double DISCOUNT_RATE = 0.9;
+static constexpr int ITERATIONS = 200;
+static constexpr int SHORTEST_PATH = 15;
+static constexpr unsigned RANDOM_SEED = 1;
+static const std::string TRAJECTORY_FILE = "windygridworld-trajectories.bin";
+
+inline int windygridworld_main() {
+    RecordTrajectory<WindyGridworld> environment;
+    environment.initialize();
+
+    {
+        TrajectoryRecorder<State, Action> recorder(TRAJECTORY_FILE);
+        environment.set_recorder(&recorder);
+        std::mt19937 generator(RANDOM_SEED);
+        for (int episode = 0; episode < N_OF_EPISODES; episode++) {
+            State s = environment.reset();
+            while (!environment.is_terminal(s)) {
+                const auto& actions = environment.actions(s);
+                s = environment.step(s, actions[generator() % actions.size()]).first;
+            }
+        }
+        environment.set_recorder(nullptr);
+    }
+
+    auto value_strategy = new TabularValueStrategy<State, Action>();
+    value_strategy->initialize(&environment);
+
+    try {
+        TrajectoryReader<State, Action> reader(output_dir + TRAJECTORY_FILE);
+        TransitionBatch<State, Action> batch(reader);
+
+        OfflineConfig config;
+        config.discount_rate = DISCOUNT_RATE;
+        config.iterations = ITERATIONS;
+        OfflineTabularSolver<State, Action> solver(batch, value_strategy, environment, config);
+        int iterations = solver.solve(OfflineTarget::FittedQ);
+        std::cout << batch.size() << " transitions, " << solver.slots() << " (state, action) pairs, " << iterations
+                  << " iterations" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Offline training failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Every move before the goal costs 1, the move into it nothing
+    Return expected = -(1 - std::pow(DISCOUNT_RATE, SHORTEST_PATH - 1)) / (1 - DISCOUNT_RATE);
+    Return learned = std::get<1>(value_strategy->get_best_action(initial_state));
+    std::cout << "V(start): learned " << learned << ", shortest path " << expected << std::endl;
+
+    EpsilonGreedyPolicy<State, Action> policy(value_strategy, 0);
+    policy.initialize(&environment, value_strategy);
+    auto optimal_policy = policy.optimal();
+    environment.plot_policy(optimal_policy);
+    std::cout << std::endl;
+    environment.output_trajectory(optimal_policy);
+
+    save_q_values(*value_strategy, "windygridworld-offline-Q.json");
+    return std::abs(learned - expected) < 1e-6 ? 0 : 1;
+}
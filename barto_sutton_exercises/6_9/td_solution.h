@@ -5,6 +5,7 @@
 #include <functional>
 #include <iostream>
 
+#include "CompiledPolicy.h"
 #include "Policy.h"
 #include "TD.h"
 #include "ValueStrategy.h"
@@ -20,12 +21,13 @@ inline int windygridworld_main() {
     WindyGridworld environment;
     environment.initialize();
 
-    auto value_strategy = new TabularValueStrategy<State, Action>();
+    auto value_strategy = new IndexedTabularValueStrategy<State, Action>();
     value_strategy->initialize(&environment);
 
     EpsilonGreedyPolicy<State, Action> policy(value_strategy, EPSILON);
 
-    TD<State, Action> mdp_solver(&environment, &policy, value_strategy, DISCOUNT_RATE, N_OF_EPISODES, ALPHA);
+    TD<State, Action, IndexedTabularValueStrategy<State, Action>> mdp_solver(&environment, &policy, value_strategy,
+                                                                             DISCOUNT_RATE, N_OF_EPISODES, ALPHA);
 
     double time_taken = benchmark([&]() { mdp_solver.policy_iteration(); });
 
@@ -39,5 +41,9 @@ inline int windygridworld_main() {
     save_q_values(*value_strategy, "windygridworld-Q.json");
     serialize_to_json(optimal_policy, "windygridworld-optimal-policy.json");
 
+    CompiledPolicy<State, Action> compiled_policy;
+    compiled_policy.compile(optimal_policy);
+    compiled_policy.save("windygridworld-policy.bin");
+
     return 0;
 }
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <malloc.h>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BoundedTabularValueStrategy.h"
+#include "benchmarks/packed_q_table.h"
+
+// Hit rate, evictions and heap ceiling of a capacity-bounded TagGame Q-table under each
+// eviction policy. Updates follow a skewed stream over a pool of distinct (State, Action)
+// pairs much larger than the capacity, so a few pairs are hot and most are seen rarely.
+static constexpr size_t BOUNDED_Q_POOL = 4000000;
+static constexpr size_t BOUNDED_Q_CAPACITY = 250000;
+static constexpr size_t BOUNDED_Q_UPDATES = 10000000;
+static constexpr uint32_t BOUNDED_Q_SEED = 5;
+
+inline std::vector<uint32_t> skewed_stream(size_t pool, size_t n) {
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    std::vector<uint32_t> stream(n);
+    for (auto& i : stream) i = static_cast<uint32_t>(pool * std::pow(uniform(generator), 4));
+    return stream;
+}
+
+inline void benchmark_eviction(const std::string& name, EvictionPolicy eviction,
+                               const std::vector<std::pair<State, Action>>& pairs,
+                               const std::vector<uint32_t>& stream) {
+    size_t heap_before = mallinfo2().uordblks;
+    auto strategy = new BoundedTabularValueStrategy<State, Action>(BOUNDED_Q_CAPACITY, eviction, BOUNDED_Q_SEED);
+
+    double time = benchmark([&]() {
+        for (uint32_t i : stream) {
+            const auto& [s, a] = pairs[i];
+            strategy->set_q(s, a, strategy->Q(s, a) + 1);
+        }
+    });
+    size_t heap_bytes = mallinfo2().uordblks - heap_before;
+
+    std::cout << name << ": hit rate " << 100.0 * strategy->hit_rate() << "%, " << strategy->metrics().evictions
+              << " evictions, " << heap_bytes / (1024 * 1024) << " MiB heap, " << time * 1e9 / stream.size()
+              << " ns/update" << std::endl;
+    delete strategy;
+}
+
+inline int bounded_q_table_main() {
+    auto pairs = random_tag_game_pairs(BOUNDED_Q_POOL);
+    auto stream = skewed_stream(BOUNDED_Q_POOL, BOUNDED_Q_UPDATES);
+    std::cout << BOUNDED_Q_UPDATES << " updates over " << BOUNDED_Q_POOL << " pairs, capacity " << BOUNDED_Q_CAPACITY
+              << std::endl;
+
+    benchmark_eviction("LeastRecentlyUpdated", EvictionPolicy::LeastRecentlyUpdated, pairs, stream);
+    benchmark_eviction("LowestVisitCount    ", EvictionPolicy::LowestVisitCount, pairs, stream);
+    benchmark_eviction("Clock               ", EvictionPolicy::Clock, pairs, stream);
+    return 0;
+}
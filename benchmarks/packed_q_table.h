@@ -0,0 +1,66 @@
+#pragma once
+
+#include <malloc.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ValueStrategy.h"
+#include "m_utils.h"
+#include "taggame/TagGame.h"
+
+// Heap use and update/lookup time of a TagGame Q-table keyed on (State, Action)
+// pairs (TabularValueStrategy) against packed uint64_t keys (PackedTabularValueStrategy).
+static constexpr size_t PACKED_Q_ENTRIES = 2000000;
+
+using PackedTagGameStrategy = PackedTabularValueStrategy<State, Action, PackedState, PackedAction>;
+
+inline std::vector<std::pair<State, Action>> random_tag_game_pairs(size_t n) {
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> position(0, 799), velocity(-3, 3);
+
+    std::vector<std::pair<State, Action>> pairs(n);
+    for (auto& [s, a] : pairs) {
+        s = {{position(generator), position(generator)},
+             {velocity(generator), velocity(generator)},
+             {position(generator), position(generator)},
+             {velocity(generator), velocity(generator)},
+             false};
+        a = {velocity(generator), velocity(generator)};
+    }
+    return pairs;
+}
+
+template <typename Strategy>
+void benchmark_q_table(const std::string& name, const std::vector<std::pair<State, Action>>& pairs) {
+    size_t heap_before = mallinfo2().uordblks;
+    auto strategy = new Strategy();
+
+    double update_time = benchmark([&]() {
+        for (size_t i = 0; i < pairs.size(); i++) strategy->set_q(pairs[i].first, pairs[i].second, i);
+    });
+    size_t heap_bytes = mallinfo2().uordblks - heap_before;
+
+    Return checksum = 0;
+    double lookup_time = benchmark([&]() {
+        for (size_t i = pairs.size(); i-- > 0;) checksum += strategy->Q(pairs[i].first, pairs[i].second);
+    });
+
+    std::cout << name << ": " << static_cast<double>(heap_bytes) / pairs.size() << " heap bytes/entry, set_q "
+              << update_time * 1e9 / pairs.size() << " ns, Q " << lookup_time * 1e9 / pairs.size() << " ns (checksum "
+              << checksum << ")" << std::endl;
+    delete strategy;
+}
+
+inline int packed_q_table_main() {
+    auto pairs = random_tag_game_pairs(PACKED_Q_ENTRIES);
+    std::cout << "sizeof(std::pair<State, Action>) = " << sizeof(std::pair<State, Action>)
+              << ", packed key = " << sizeof(uint64_t) << " (" << PackedState::BITS + PackedAction::BITS << " bits)"
+              << std::endl;
+
+    benchmark_q_table<TabularValueStrategy<State, Action>>("TabularValueStrategy      ", pairs);
+    benchmark_q_table<PackedTagGameStrategy>("PackedTabularValueStrategy", pairs);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MDP.h"
+#include "StateActionTable.h"
+#include "StateIndexer.h"
+#include "ValueStrategy.h"
+#include "m_utils.h"
+
+// Build and lookup time of the minimal perfect hash StateIndexer against the
+// unordered_map based HashStateIndexer, for state sets of 10^3 to 10^7 states.
+// Then, at the sizes of the tabular examples (Windy Gridworld's 70 states,
+// Blackjack's 200, and 10^3), the dense storage built on the indexer against
+// the maps it replaces: a greedy decision (IndexedTabularValueStrategy against
+// TabularValueStrategy) and a visit count increment (StateActionTable against
+// unordered_map).
+using IndexedState = std::pair<int, int>;
+
+static constexpr int INDEXER_MAX_EXPONENT = 7;
+static constexpr size_t INDEXER_LOOKUPS = 10000000;
+static constexpr size_t TABLE_LOOKUPS = 10000000;
+
+// States spread over the int range, each with `action_count` actions
+class IndexedBenchmarkMDP : public MDP<IndexedState, int> {
+   private:
+    size_t m_state_count;
+    int m_action_count;
+
+   public:
+    IndexedBenchmarkMDP(size_t state_count, int action_count)
+        : m_state_count(state_count), m_action_count(action_count) {}
+
+    void initialize() override {
+        for (size_t i = 0; i < m_state_count; i++) {
+            IndexedState s = {static_cast<int>(i * 2654435761u), static_cast<int>(i)};
+            m_S.push_back(s);
+            for (int a = 0; a < m_action_count; a++) m_A[s].push_back(a);
+        }
+        index_states();
+    }
+};
+
+template <typename Indexer>
+void benchmark_indexer(const std::string& name, const std::vector<IndexedState>& states,
+                       const std::vector<IndexedState>& queries) {
+    Indexer indexer;
+    double build_time = benchmark([&]() { indexer.build(states); });
+
+    size_t checksum = 0;
+    double lookup_time = benchmark([&]() {
+        for (const IndexedState& s : queries) checksum += indexer.index(s);
+    });
+
+    std::cout << "  " << name << ": build " << build_time << " s (" << build_time * 1e9 / states.size()
+              << " ns/state), lookup " << lookup_time * 1e9 / queries.size() << " ns (checksum " << checksum << ")"
+              << std::endl;
+}
+
+template <typename Strategy>
+double benchmark_greedy(IndexedBenchmarkMDP& environment, const std::vector<IndexedState>& queries, int& checksum) {
+    Strategy strategy;
+    strategy.initialize(&environment);
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<Return> value(-1, 1);
+    for (const IndexedState& s : environment.states()) {
+        for (int a : environment.actions(s)) strategy.set_q(s, a, value(generator));
+    }
+
+    checksum = 0;
+    double seconds = benchmark([&]() {
+        for (const IndexedState& s : queries) checksum += std::get<0>(strategy.get_best_action(s));
+    });
+    return seconds * 1e9 / queries.size();
+}
+
+template <typename Counts>
+double benchmark_counts(Counts& counts, const std::vector<IndexedState>& queries, int action_count) {
+    double seconds = benchmark([&]() {
+        int a = 0;
+        for (const IndexedState& s : queries) {
+            counts[{s, a}]++;
+            if (++a == action_count) a = 0;
+        }
+    });
+    return seconds * 1e9 / queries.size();
+}
+
+inline void benchmark_tables(size_t state_count, int action_count, std::mt19937& generator) {
+    IndexedBenchmarkMDP environment(state_count, action_count);
+    environment.initialize();
+
+    std::vector<IndexedState> queries(TABLE_LOOKUPS);
+    std::uniform_int_distribution<size_t> pick(0, state_count - 1);
+    for (IndexedState& q : queries) q = environment.states()[pick(generator)];
+
+    std::cout << state_count << " states, " << action_count << " actions" << std::endl;
+    int map_checksum, dense_checksum;
+    double map_greedy = benchmark_greedy<TabularValueStrategy<IndexedState, int>>(environment, queries, map_checksum);
+    double dense_greedy =
+        benchmark_greedy<IndexedTabularValueStrategy<IndexedState, int>>(environment, queries, dense_checksum);
+    std::cout << "  greedy action: TabularValueStrategy " << map_greedy << " ns, IndexedTabularValueStrategy "
+              << dense_greedy << " ns (checksums " << map_checksum << ", " << dense_checksum << ")" << std::endl;
+
+    std::unordered_map<std::pair<IndexedState, int>, int, StateActionPairHash<IndexedState, int>> map_counts;
+    StateActionTable<IndexedState, int, int> dense_counts;
+    dense_counts.initialize(environment);
+    std::cout << "  visit count: unordered_map " << benchmark_counts(map_counts, queries, action_count)
+              << " ns, StateActionTable " << benchmark_counts(dense_counts, queries, action_count) << " ns"
+              << std::endl;
+}
+
+inline int state_indexer_main() {
+    std::mt19937 generator(42);
+
+    benchmark_tables(70, 4, generator);
+    benchmark_tables(200, 2, generator);
+    benchmark_tables(1000, 4, generator);
+
+    size_t n = 1;
+    for (int exponent = 1; exponent <= INDEXER_MAX_EXPONENT; exponent++) {
+        n *= 10;
+        if (exponent < 3) continue;
+
+        // distinct states spread over the int range
+        std::vector<IndexedState> states(n);
+        for (size_t i = 0; i < n; i++) states[i] = {static_cast<int>(i * 2654435761u), static_cast<int>(i)};
+
+        std::vector<IndexedState> queries(INDEXER_LOOKUPS);
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        for (IndexedState& q : queries) q = states[pick(generator)];
+
+        std::cout << n << " states" << std::endl;
+        benchmark_indexer<HashStateIndexer<IndexedState>>("HashStateIndexer", states, queries);
+        benchmark_indexer<StateIndexer<IndexedState>>("StateIndexer    ", states, queries);
+
+        StateIndexer<IndexedState> indexer;
+        indexer.build(states);
+        std::cout << "  StateIndexer uses " << indexer.bits_per_state() << " bits/state plus the stored states"
+                  << std::endl;
+    }
+
+    return 0;
+}
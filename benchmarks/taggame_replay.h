@@ -0,0 +1,100 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+
+#include "FunctionApproximator.h"
+#include "MDPWrappers.h"
+#include "ValueStrategy.h"
+#include "m_utils.h"
+#include "serialization.h"
+#include "taggame/ReplayTagGame.h"
+#include "taggame/SimulatedTagGame.h"
+#include "taggame/TagGameFeatures.h"
+
+// Decision latency of the greedy FA agent on a recorded TagGame session, without
+// the Java server. Replays the trace recorded by play_solution.h (RECORD_TRACE);
+// without one, a trace of random play is recorded from the in-process simulator.
+static const std::string REPLAY_TRACE_FILE = "taggame_trace.log";
+static const std::string REPLAY_SIMULATED_TRACE_FILE = "taggame_simulated_trace.log";
+static const std::string REPLAY_WEIGHTS_FILE = "taggame_fa_weights.json";
+static constexpr int REPLAY_EPISODES = 2000;
+static constexpr int REPLAY_SIMULATED_EPISODES = 100;
+static constexpr int REPLAY_ACTION_REPEAT = 4;
+
+// The server's reply for a state, as TagGame::parse_state reads it
+inline std::string trace_reply(const State& s, TimeStep ticks) {
+    const auto& [mp, mv, tp, tv, t] = s;
+    nlohmann::json reply;
+    reply["mp"] = {mp.first, mp.second};
+    reply["mv"] = {mv.first, mv.second};
+    reply["tp"] = {tp.first, tp.second};
+    reply["tv"] = {tv.first, tv.second};
+    reply["t"] = t;
+    reply["n"] = ticks;
+    return reply.dump();
+}
+
+inline void record_simulated_trace(const std::string& file_path) {
+    ActionRepeat<SimulatedTagGame> environment;
+    environment.set_action_repeat(REPLAY_ACTION_REPEAT);
+    environment.initialize();
+    std::mt19937 generator(1);
+    const auto& actions = environment.all_actions();
+
+    std::ofstream trace(file_path);
+    for (int episode = 0; episode < REPLAY_SIMULATED_EPISODES; episode++) {
+        State s = environment.reset();
+        trace << Communicator::TRACE_SENT << Communicator::getInstance().RESET << '\n'
+              << Communicator::TRACE_RECEIVED << trace_reply(s, 1) << '\n';
+        while (!environment.is_terminal(s)) {
+            Action a = actions[generator() % actions.size()];
+            State s_prime = environment.step(s, a).first;
+            trace << Communicator::TRACE_SENT << environment.serialize_action(a, REPLAY_ACTION_REPEAT) << '\n'
+                  << Communicator::TRACE_RECEIVED << trace_reply(s_prime, environment.step_duration()) << '\n';
+            s = s_prime;
+        }
+    }
+}
+
+inline int taggame_replay_main() {
+    std::string trace_file = output_dir + REPLAY_TRACE_FILE;
+    if (!std::filesystem::exists(trace_file)) {
+        trace_file = output_dir + REPLAY_SIMULATED_TRACE_FILE;
+    }
+    if (!std::filesystem::exists(trace_file)) {
+        std::cout << "No recorded session, recording random play to " << trace_file << std::endl;
+        record_simulated_trace(trace_file);
+    }
+
+    ActionRepeat<ReplayTagGame> environment(trace_file);
+    environment.set_action_repeat(REPLAY_ACTION_REPEAT);
+    environment.initialize();
+
+    LinearFunctionApproximator<State, Action> approximator(TAGGAME_FEATURE_COUNT, taggame_features);
+    load_approximator(&approximator, output_dir + REPLAY_WEIGHTS_FILE);
+    ApproximationValueStrategy<State, Action> greedy;
+
+    double seconds = benchmark([&]() {
+        for (int episode = 0; episode < REPLAY_EPISODES; episode++) {
+            State s = environment.reset();
+            while (!environment.is_terminal(s)) {
+                Action a = std::get<0>(greedy.get_best_action_static(environment, approximator, s));
+                s = environment.step(s, a).first;
+            }
+        }
+    });
+
+    std::cout << environment.episodes() << " recorded episodes, " << environment.decisions() << " decisions in "
+              << seconds << " s (" << environment.decisions() / seconds << " decisions/s)" << std::endl;
+    std::cout << "Decision latency: mean " << environment.mean_latency_us() << " us, p50 "
+              << environment.latency_percentile_us(0.5) << " us, p99 " << environment.latency_percentile_us(0.99)
+              << " us, max " << environment.latency_percentile_us(1) << " us" << std::endl;
+    std::cout << "Recorded action chosen in " << 100 * environment.action_agreement() << "% of decisions"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "taggame/Transport.h"
+
+// Step round-trip time of each agent-game transport. A thread in this process
+// plays the game's side and answers every action with a typical state, so the
+// numbers are transport overhead only; the game's own tick comes on top.
+static constexpr int TRANSPORT_WARMUP_STEPS = 2000;
+static constexpr int TRANSPORT_STEPS = 50000;
+static const std::string TRANSPORT_BENCHMARK_SOCKET = "/tmp/taggame_benchmark.sock";
+static const std::string TRANSPORT_BENCHMARK_SHM = "/dev/shm/taggame_benchmark";
+static const std::string TRANSPORT_ACTION = R"({"k":4,"x":-2,"y":1})";
+static const std::string TRANSPORT_STATE = R"({"mp":[485,296],"mv":[-1,1],"n":4,"t":false,"tp":[351,681],"tv":[1,-1]})";
+
+// Listening socket of the game's side; for TCP, the port is picked by the system
+inline int listen_socket(TransportKind kind, int& port) {
+    int fd;
+    if (kind == TransportKind::Tcp) {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+    } else {
+        ::unlink(TRANSPORT_BENCHMARK_SOCKET.c_str());
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, TRANSPORT_BENCHMARK_SOCKET.c_str());
+        ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    if (::listen(fd, 1) != 0) throw std::runtime_error("Failed to listen for the benchmark");
+    return fd;
+}
+
+inline void serve(Transport& game) {
+    try {
+        while (true) {
+            game.receive();
+            game.send(TRANSPORT_STATE);
+        }
+    } catch (const std::exception&) {
+        // The agent disconnected
+    }
+}
+
+inline void report_round_trips(const std::string& name, std::vector<int64_t> ns) {
+    std::sort(ns.begin(), ns.end());
+    auto percentile = [&](double p) { return ns[std::min(ns.size() - 1, static_cast<size_t>(p * ns.size()))] / 1000.0; };
+    double total = 0;
+    for (int64_t t : ns) total += t;
+    std::cout << name << ": mean " << total / ns.size() / 1000 << " us, p50 " << percentile(0.5) << " us, p99 "
+              << percentile(0.99) << " us, p99.9 " << percentile(0.999) << " us" << std::endl;
+}
+
+inline void run_transport(const std::string& name, TransportConfig config) {
+    std::unique_ptr<Transport> game;
+    std::thread server;
+    if (config.kind == TransportKind::SharedMemory) {
+        config.path = TRANSPORT_BENCHMARK_SHM;
+        game = SharedMemoryTransport::create(config.path, config.spin_iterations);
+        server = std::thread([&] { serve(*game); });
+    } else {
+        int listener = listen_socket(config.kind, config.port);
+        config.path = TRANSPORT_BENCHMARK_SOCKET;
+        server = std::thread([&, listener] {
+            int fd = ::accept(listener, nullptr, nullptr);
+            ::close(listener);
+            int on = 1;
+            if (config.kind == TransportKind::Tcp) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            SocketTransport transport(fd);
+            serve(transport);
+        });
+    }
+
+    std::vector<int64_t> round_trips;
+    round_trips.reserve(TRANSPORT_STEPS);
+    {
+        std::unique_ptr<Transport> agent = open_transport(config);
+        for (int step = 0; step < TRANSPORT_WARMUP_STEPS + TRANSPORT_STEPS; step++) {
+            auto start = std::chrono::steady_clock::now();
+            agent->send(TRANSPORT_ACTION);
+            agent->receive();
+            auto end = std::chrono::steady_clock::now();
+            if (step >= TRANSPORT_WARMUP_STEPS) {
+                round_trips.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            }
+        }
+    }
+    server.join();
+    game.reset();
+    ::unlink(config.path.c_str());
+
+    report_round_trips(name, std::move(round_trips));
+}
+
+inline int taggame_transport_main() {
+    TransportConfig config;
+    config.kind = TransportKind::Tcp;
+    run_transport("TCP (TCP_NODELAY)", config);
+    config.kind = TransportKind::Unix;
+    run_transport("Unix domain socket", config);
+    config.kind = TransportKind::SharedMemory;
+    if (std::thread::hardware_concurrency() < 2) {
+        config.spin_iterations = 0;  // spinning only helps when both sides have a core of their own
+    }
+    run_transport("Shared memory ring", config);
+    return 0;
+}
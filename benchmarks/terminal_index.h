@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MDP.h"
+#include "m_utils.h"
+
+// Checks MDP::is_terminal against a linear std::find over the terminal states,
+// for each index it can pick: the bitset (dense integral states) and the hash
+// set (sparse integral states, pair states), and times both lookups.
+static constexpr int TERMINAL_INDEX_COUNT = 5000;
+static constexpr int TERMINAL_INDEX_QUERIES = 200000;
+
+template <typename State>
+class TerminalIndexMDP : public MDP<State, int> {
+   public:
+    explicit TerminalIndexMDP(std::vector<State> terminals) : m_terminals(std::move(terminals)) {}
+    void initialize() override { this->set_terminals(m_terminals); }
+
+   private:
+    std::vector<State> m_terminals;
+};
+
+template <typename State>
+bool check_terminal_index(const std::string& name, const std::vector<State>& terminals,
+                          const std::vector<State>& queries, bool expect_bitset) {
+    TerminalIndexMDP<State> environment(terminals);
+    environment.initialize();
+    const auto& T = environment.terminals();
+
+    std::vector<char> indexed(queries.size()), found(queries.size());
+    double index_time = benchmark([&]() {
+        for (size_t i = 0; i < queries.size(); i++) indexed[i] = environment.is_terminal(queries[i]);
+    });
+    double find_time = benchmark([&]() {
+        for (size_t i = 0; i < queries.size(); i++) found[i] = std::find(T.begin(), T.end(), queries[i]) != T.end();
+    });
+
+    size_t mismatches = 0, terminal_count = 0;
+    for (size_t i = 0; i < queries.size(); i++) {
+        mismatches += indexed[i] != found[i];
+        terminal_count += found[i];
+    }
+
+    std::cout << name << " (" << (environment.terminal_bitset_used() ? "bitset" : "hash set") << "): " << terminal_count
+              << "/" << queries.size() << " terminal, " << mismatches << " mismatches, is_terminal "
+              << index_time * 1e9 / queries.size() << " ns, std::find " << find_time * 1e9 / queries.size() << " ns"
+              << std::endl;
+    return mismatches == 0 && environment.terminal_bitset_used() == expect_bitset;
+}
+
+inline int terminal_index_main() {
+    std::mt19937 generator(3);
+    std::uniform_int_distribution<int> offset(-10, 2 * TERMINAL_INDEX_COUNT + 10);
+
+    // every other integer, so the range is dense enough for the bitset
+    std::vector<int> dense;
+    for (int i = 0; i < TERMINAL_INDEX_COUNT; i++) dense.push_back(2 * i);
+    std::vector<int> dense_queries(TERMINAL_INDEX_QUERIES);
+    for (int& q : dense_queries) q = offset(generator);
+
+    // one far-away terminal makes the range too sparse for the bitset
+    std::vector<int> sparse = dense;
+    sparse.push_back(1 << 30);
+    std::vector<int> sparse_queries = dense_queries;
+    sparse_queries[0] = 1 << 30;
+
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < TERMINAL_INDEX_COUNT; i++) pairs.push_back({i, 2 * i});
+    std::vector<std::pair<int, int>> pair_queries(TERMINAL_INDEX_QUERIES);
+    for (auto& q : pair_queries) {
+        int i = offset(generator) / 2;
+        q = {i, 2 * i + (generator() % 2)};
+    }
+
+    bool ok = check_terminal_index("Dense int states ", dense, dense_queries, true);
+    ok &= check_terminal_index("Sparse int states", sparse, sparse_queries, false);
+    ok &= check_terminal_index("Pair states      ", pairs, pair_queries, false);
+    if (!ok) {
+        std::cerr << "is_terminal disagrees with std::find over the terminal states" << std::endl;
+        return 1;
+    }
+    return 0;
+}
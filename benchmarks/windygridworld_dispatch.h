@@ -0,0 +1,93 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "FA_TD.h"
+#include "FunctionApproximator.h"
+#include "MDPWrappers.h"
+#include "Policy.h"
+#include "TD.h"
+#include "ValueStrategy.h"
+#include "barto_sutton_exercises/6_9/WindyGridworld.h"
+
+// Throughput of the virtual-dispatch solvers (TD, FA_TD) against their statically
+// bound variants (StaticTD, StaticFA_TD) on Windy Gridworld. Episode lengths depend
+// on what the agent has learned, so steps per second is the fairer comparison. Both
+// FA solvers use the same non-allocating approximator, so only the dispatch differs.
+static constexpr int BENCHMARK_EPISODES = 200000;
+static constexpr int BENCHMARK_FA_EPISODES = 100000;
+static constexpr double BENCHMARK_DISCOUNT_RATE = 0.9;
+static constexpr double BENCHMARK_EPSILON = 0.1;
+static constexpr double BENCHMARK_ALPHA = 0.1;
+
+using BenchmarkGridworld = RecordEpisodeStatistics<WindyGridworld>;
+
+// One-hot feature of each (state, action) pair
+struct GridworldFeatures {
+    void operator()(const State& s, const Action& a, std::vector<std::pair<size_t, double>>& features) const {
+        int action_idx = 0;
+        for (size_t i = 0; i < possible_actions.size(); i++) {
+            if (possible_actions[i] == a) action_idx = i;
+        }
+        features.emplace_back((s.first * COL_COUNT + s.second) * possible_actions.size() + action_idx, 1.0);
+    }
+};
+using GridworldApproximator = StaticLinearFunctionApproximator<State, Action, GridworldFeatures>;
+
+inline void report(const std::string& name, const BenchmarkGridworld& environment, double seconds) {
+    long steps = 0;
+    for (int length : environment.episode_lengths()) steps += length;
+
+    std::cout << name << ": " << environment.episode_lengths().size() / seconds << " episodes/s, " << steps / seconds
+              << " steps/s (" << seconds << " s)" << std::endl;
+}
+
+inline void run_tabular(const std::string& name, bool static_dispatch) {
+    BenchmarkGridworld environment;
+    environment.initialize();
+
+    TabularValueStrategy<State, Action> value_strategy;
+    value_strategy.initialize(&environment);
+    EpsilonGreedyPolicy<State, Action> policy(&value_strategy, BENCHMARK_EPSILON);
+
+    if (static_dispatch) {
+        StaticTD<BenchmarkGridworld, EpsilonGreedyPolicy<State, Action>> solver(
+            &environment, &policy, &value_strategy, BENCHMARK_DISCOUNT_RATE, BENCHMARK_EPISODES, BENCHMARK_ALPHA);
+        report(name, environment, benchmark([&]() { solver.policy_iteration(); }));
+    } else {
+        TD<State, Action> solver(&environment, &policy, &value_strategy, BENCHMARK_DISCOUNT_RATE, BENCHMARK_EPISODES,
+                                 BENCHMARK_ALPHA);
+        report(name, environment, benchmark([&]() { solver.policy_iteration(); }));
+    }
+}
+
+inline void run_approximation(const std::string& name, bool static_dispatch) {
+    BenchmarkGridworld environment;
+    environment.initialize();
+
+    GridworldApproximator approximator(ROW_COUNT * COL_COUNT * possible_actions.size());
+    ApproximationValueStrategy<State, Action> value_strategy;
+    value_strategy.initialize(&environment, &approximator);
+    EpsilonGreedyPolicy<State, Action> policy(&value_strategy, BENCHMARK_EPSILON);
+
+    if (static_dispatch) {
+        StaticFA_TD<BenchmarkGridworld, EpsilonGreedyPolicy<State, Action>, GridworldApproximator> solver(
+            &environment, &policy, &value_strategy, &approximator, BENCHMARK_DISCOUNT_RATE, BENCHMARK_FA_EPISODES,
+            BENCHMARK_ALPHA);
+        report(name, environment, benchmark([&]() { solver.policy_iteration(); }));
+    } else {
+        FA_TD<State, Action> solver(&environment, &policy, &value_strategy, BENCHMARK_DISCOUNT_RATE,
+                                    BENCHMARK_FA_EPISODES, BENCHMARK_ALPHA);
+        report(name, environment, benchmark([&]() { solver.policy_iteration(); }));
+    }
+}
+
+inline int windygridworld_main() {
+    run_tabular("TD (virtual)", false);
+    run_tabular("StaticTD", true);
+    run_approximation("FA_TD (virtual)", false);
+    run_approximation("StaticFA_TD", true);
+    return 0;
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DiscretizedValueStrategy.h"
+#include "MappedFile.h"
+#include "StateCodec.h"
+#include "ValueStrategy.h"
+#include "m_types.h"
+#include "m_utils.h"
+
+// Binary Q-table checkpoints. A checkpoint is a list of (Key, Return) entries:
+//
+//   header | keys: count x FlatCodec<Key>::WIDTH int32 words | padding to 8 bytes | values: count x Return
+//
+// in native endianness. The header carries a hash of the key and value types and
+// an FNV-1a checksum of everything after it, so a file written for other state or
+// action types, or damaged on disk, is rejected instead of misread. QCheckpoint
+// maps the file and decodes entries on demand; nothing is parsed up front.
+//
+// These are the resume format. The JSON savers in serialization.h remain for
+// inspecting tables by hand.
+
+namespace checkpoint_detail {
+
+constexpr char MAGIC[4] = {'R', 'L', 'Q', 'C'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t key_width;
+    uint32_t reserved;
+    uint64_t signature;
+    uint64_t count;
+    uint64_t checksum;
+};
+
+template <typename Key>
+uint64_t signature() {
+    std::string description = FlatCodec<Key>::signature() + "->f" + std::to_string(8 * sizeof(Return));
+    uint64_t hash = FNV_OFFSET;
+    for (unsigned char c : description) hash = (hash ^ c) * FNV_PRIME;
+    return hash;
+}
+
+inline size_t values_offset(size_t key_words) {
+    size_t end = sizeof(Header) + key_words * sizeof(int32_t);
+    return (end + 7) / 8 * 8;
+}
+
+}  // namespace checkpoint_detail
+
+// Writes `count` entries produced by for_each(emit), where emit(const Key&, Return)
+// must be called exactly `count` times. Keys are streamed to the file; only the
+// values are buffered until the key section is complete.
+template <typename Key, typename ForEach>
+bool write_q_checkpoint(const std::string& file_path, size_t count, ForEach&& for_each) {
+    using namespace checkpoint_detail;
+    using KeyCodec = FlatCodec<Key>;
+
+    std::ofstream file(output_dir + file_path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing Q checkpoint: " << file_path << std::endl;
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key_width = KeyCodec::WIDTH;
+    header.signature = signature<Key>();
+    header.count = count;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Full chunks are a whole number of 64-bit words, and the zero padding after the
+    // keys completes the last partial word, so checksumming chunk by chunk matches
+    // one pass over the file
+    static constexpr size_t CHUNK_KEYS = 8192;
+    std::vector<int32_t> chunk;
+    chunk.reserve(CHUNK_KEYS * KeyCodec::WIDTH);
+    std::vector<Return> values;
+    values.reserve(count);
+    uint64_t checksum = FNV_OFFSET;
+
+    auto flush = [&]() {
+        const char* bytes = reinterpret_cast<const char*>(chunk.data());
+        checksum = fnv1a(checksum, bytes, chunk.size() * sizeof(int32_t));
+        file.write(bytes, chunk.size() * sizeof(int32_t));
+        chunk.clear();
+    };
+
+    for_each([&](const Key& key, Return value) {
+        chunk.resize(chunk.size() + KeyCodec::WIDTH);
+        KeyCodec::encode(key, chunk.data() + chunk.size() - KeyCodec::WIDTH);
+        values.push_back(value);
+        if (chunk.size() == CHUNK_KEYS * KeyCodec::WIDTH) flush();
+    });
+    flush();
+
+    if (values.size() != count) {
+        std::cerr << "Failed to write Q checkpoint: expected " << count << " entries, got " << values.size()
+                  << std::endl;
+        return false;
+    }
+
+    size_t key_end = sizeof(Header) + count * KeyCodec::WIDTH * sizeof(int32_t);
+    const char padding[8] = {};
+    file.write(padding, values_offset(count * KeyCodec::WIDTH) - key_end);
+
+    const char* value_bytes = reinterpret_cast<const char*>(values.data());
+    checksum = fnv1a(checksum, value_bytes, values.size() * sizeof(Return));
+    file.write(value_bytes, values.size() * sizeof(Return));
+
+    header.checksum = checksum;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!file) {
+        std::cerr << "Failed to write Q checkpoint: " << file_path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Read-only view of a mapped checkpoint. Throws std::runtime_error if the file is
+// not a checkpoint of this Key type or fails its checksum.
+template <typename Key>
+class QCheckpoint {
+   private:
+    using KeyCodec = FlatCodec<Key>;
+
+    MappedFile m_file;
+    size_t m_count = 0;
+    const int32_t* m_keys = nullptr;
+    const Return* m_values = nullptr;
+
+   public:
+    explicit QCheckpoint(const std::string& file_path, bool verify_checksum = true) : m_file(file_path) {
+        using namespace checkpoint_detail;
+
+        Header header;
+        if (m_file.size() < sizeof(header)) throw std::runtime_error("file too small");
+        std::memcpy(&header, m_file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            throw std::runtime_error("not a Q checkpoint of version " + std::to_string(VERSION));
+        }
+        if (header.key_width != KeyCodec::WIDTH || header.signature != signature<Key>()) {
+            throw std::runtime_error("state or action type does not match the file");
+        }
+
+        size_t offset = values_offset(header.count * KeyCodec::WIDTH);
+        if (m_file.size() != offset + header.count * sizeof(Return)) {
+            throw std::runtime_error("truncated or oversized file");
+        }
+        if (verify_checksum &&
+            fnv1a(FNV_OFFSET, m_file.data() + sizeof(header), m_file.size() - sizeof(header)) != header.checksum) {
+            throw std::runtime_error("checksum mismatch");
+        }
+
+        m_count = header.count;
+        m_keys = reinterpret_cast<const int32_t*>(m_file.data() + sizeof(header));
+        m_values = reinterpret_cast<const Return*>(m_file.data() + offset);
+    }
+
+    size_t size() const { return m_count; }
+    Key key(size_t i) const { return KeyCodec::decode(m_keys + i * KeyCodec::WIDTH); }
+    Return value(size_t i) const { return m_values[i]; }
+    const Return* values() const { return m_values; }
+};
+
+template <typename State, typename Action>
+bool save_q_checkpoint(const TabularValueStrategy<State, Action>& strategy, const std::string& file_path) {
+    const auto& Q = strategy.get_Q();
+    return write_q_checkpoint<std::pair<State, Action>>(file_path, Q.size(), [&](auto&& emit) {
+        for (const auto& [key, value] : Q) emit(key, value);
+    });
+}
+
+template <typename State, typename Action>
+bool load_q_checkpoint(TabularValueStrategy<State, Action>& strategy, const std::string& file_path) {
+    try {
+        if (!std::filesystem::exists(file_path)) return false;
+
+        QCheckpoint<std::pair<State, Action>> checkpoint(file_path);
+        strategy.mutable_Q().reserve(strategy.get_Q().size() + checkpoint.size());
+        for (size_t i = 0; i < checkpoint.size(); i++) {
+            auto [s, a] = checkpoint.key(i);
+            strategy.set_q(s, a, checkpoint.value(i));
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load Q checkpoint: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+template <typename State, typename Action, typename StateCodec, typename ActionCodec>
+bool save_q_checkpoint(const PackedTabularValueStrategy<State, Action, StateCodec, ActionCodec>& strategy,
+                       const std::string& file_path) {
+    const auto& Q = strategy.get_Q();
+    return write_q_checkpoint<std::pair<State, Action>>(file_path, Q.size(), [&](auto&& emit) {
+        for (const auto& [key, value] : Q) emit(strategy.unpack(key), value);
+    });
+}
+
+template <typename State, typename Action, typename StateCodec, typename ActionCodec>
+bool load_q_checkpoint(PackedTabularValueStrategy<State, Action, StateCodec, ActionCodec>& strategy,
+                       const std::string& file_path) {
+    try {
+        if (!std::filesystem::exists(file_path)) return false;
+
+        QCheckpoint<std::pair<State, Action>> checkpoint(file_path);
+        strategy.get_Q().reserve(strategy.get_Q().size() + checkpoint.size());
+        for (size_t i = 0; i < checkpoint.size(); i++) {
+            auto [s, a] = checkpoint.key(i);
+            strategy.set_q(s, a, checkpoint.value(i));
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load Q checkpoint: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+// Entries are (discretized key, action) pairs of the visited keys
+template <typename State, typename Action, typename Discretizer>
+bool save_q_checkpoint(const DiscretizedValueStrategy<State, Action, Discretizer>& strategy,
+                       const std::string& file_path) {
+    const auto& actions = strategy.actions();
+    return write_q_checkpoint<std::pair<uint32_t, Action>>(
+        file_path, strategy.visited_keys() * actions.size(), [&](auto&& emit) {
+            for (size_t key = 0; key < strategy.table_size(); key++) {
+                if (!strategy.visited(key)) continue;
+                const Return* values = strategy.values(key);
+                for (size_t i = 0; i < actions.size(); i++) emit({static_cast<uint32_t>(key), actions[i]}, values[i]);
+            }
+        });
+}
+
+template <typename State, typename Action, typename Discretizer>
+bool load_q_checkpoint(DiscretizedValueStrategy<State, Action, Discretizer>& strategy,
+                       const std::string& file_path) {
+    try {
+        if (!std::filesystem::exists(file_path)) return false;
+
+        QCheckpoint<std::pair<uint32_t, Action>> checkpoint(file_path);
+        const auto& actions = strategy.actions();
+        const size_t n_actions = actions.size();
+        if (checkpoint.size() % n_actions != 0) {
+            throw std::runtime_error("action set differs from the file");
+        }
+
+        // Validate everything before touching the table
+        for (size_t i = 0; i < checkpoint.size(); i++) {
+            auto [key, action] = checkpoint.key(i);
+            if (key >= strategy.table_size() || action != actions[i % n_actions]) {
+                throw std::runtime_error("discretization or action set differs from the file");
+            }
+        }
+        for (size_t i = 0; i < checkpoint.size(); i += n_actions) {
+            uint32_t key = checkpoint.key(i).first;
+            std::copy(checkpoint.values() + i, checkpoint.values() + i + n_actions, strategy.values(key));
+            strategy.mark_visited(key);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load Q checkpoint: " << e.what() << std::endl;
+        return false;
+    }
+}
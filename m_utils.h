@@ -3,6 +3,7 @@
 #include <cerrno>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -26,6 +27,26 @@ double poisson_probability(int k, double lambda);
 int random_value(int, int);
 double random_value(double, double);
 
+// FNV-1a over 64-bit words (a trailing partial word is zero-padded), used as the
+// checksum of the binary checkpoint formats
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+inline uint64_t fnv1a(uint64_t hash, const char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, size - i);
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    return hash;
+}
+
 template <typename Func>
 double benchmark(Func&& func) {
     auto start_time = std::chrono::high_resolution_clock::now();
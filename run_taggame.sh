@@ -7,5 +7,13 @@ if ! command -v mvn &> /dev/null; then
     echo "Maven installed successfully!"
 fi
 
+# `./run_taggame.sh headless [seed]` runs the fixed-timestep runner without rendering
+MAIN_CLASS=taggame.SlickGraphicsRunner
+if [ "$1" == "headless" ]; then
+    MAIN_CLASS=taggame.InMemoryRunner
+    shift
+fi
+
+# JVM options such as -Dtaggame.transport=shm can be passed in JAVA_OPTS
 # Navigate to taggame-java, compile, and run
-cd taggame-java && mvn compile && java -cp "target/classes:lib/geom2D/javaGeom-0.11.1.jar:lib/slick2D/slick.jar:lib/slick2D/lwjgl.jar:lib/slick2D/lwjgl_util.jar:$HOME/.m2/repository/org/json/json/20231013/json-20231013.jar" -Djava.library.path=natives taggame.SlickGraphicsRunner
+cd taggame-java && mvn compile && java $JAVA_OPTS -cp "target/classes:lib/geom2D/javaGeom-0.11.1.jar:lib/slick2D/slick.jar:lib/slick2D/lwjgl.jar:lib/slick2D/lwjgl_util.jar:$HOME/.m2/repository/org/json/json/20231013/json-20231013.jar" -Djava.library.path=natives $MAIN_CLASS "$@"
@@ -1,146 +1,57 @@
 #pragma once
 
 #include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
-#include <sstream>
 #include <string>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
+#include "DiscretizedValueStrategy.h"
 #include "FunctionApproximator.h"
+#include "JsonStream.h"
+#include "StateCodec.h"
+#include "TextCodec.h"
 #include "ValueStrategy.h"
 #include "m_types.h"
 #include "m_utils.h"
 
+// Text form of a state, action or (state, action) key; see TextCodec.h
 template <typename T>
-std::string key_to_string(const T& key);
-
-template <>
-inline std::string key_to_string<int>(const int& key) {
-    return std::to_string(key);
-}
-
-template <>
-inline std::string key_to_string<std::vector<int>>(const std::vector<int>& vec) {
-    std::ostringstream oss;
-    oss << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        if (i > 0) oss << ", ";
-        oss << vec[i];
-    }
-    oss << "]";
-    return oss.str();
-}
-
-template <>
-inline std::string key_to_string<std::tuple<int, int, bool>>(const std::tuple<int, int, bool>& key) {
-    const auto& [a, b, c] = key;
-    return "(" + std::to_string(a) + ", " + std::to_string(b) + ", " + (c ? "true" : "false") + ")";
-}
-
-template <>
-inline std::string key_to_string<std::pair<std::tuple<int, int, bool>, bool>>(
-    const std::pair<std::tuple<int, int, bool>, bool>& key) {
-    const auto& [state, action] = key;
-    const auto& [a, b, c] = state;
-    return "(" + std::to_string(a) + ", " + std::to_string(b) + ", " + (c ? "true" : "false") + ")," +
-           (action ? "hit" : "stick");
-}
-
-template <>
-inline std::string key_to_string<std::tuple<std::pair<int, int>, std::pair<int, int>, int>>(
-    const std::tuple<std::pair<int, int>, std::pair<int, int>, int>& key) {
-    const auto& [vec1, vec2, dist] = key;
-
-    auto vec_to_string = [](const std::pair<int, int>& vec) {
-        return "(" + std::to_string(static_cast<int>(vec.first)) + ", " + std::to_string(static_cast<int>(vec.second)) +
-               ")";
-    };
-
-    return "{" + vec_to_string(vec1) + ", " + vec_to_string(vec2) + ", " + std::to_string(dist) + "}";
-}
-
-template <>
-inline std::string key_to_string<std::pair<int, int>>(const std::pair<int, int>& key) {
-    return "(" + std::to_string(key.first) + ", " + std::to_string(key.second) + ")";
-}
-
-template <>
-inline std::string key_to_string<std::pair<std::pair<int, int>, std::pair<int, int>>>(
-    const std::pair<std::pair<int, int>, std::pair<int, int>>& key) {
-    return "((" + std::to_string(key.first.first) + ", " + std::to_string(key.first.second) + "), (" +
-           std::to_string(key.second.first) + ", " + std::to_string(key.second.second) + "))";
+std::string key_to_string(const T& key) {
+    return to_text(key);
 }
 
 // Generic serialization function for unordered_map with any key type
 template <typename Key, typename Value, typename Hash>
 void serialize_to_json(const std::unordered_map<Key, Value, Hash>& map, const std::string& filename) {
-    nlohmann::json j;
+    JsonWriter writer(output_dir + filename);
+    writer.begin_object();
+    std::string key_text;
     for (const auto& [key, value] : map) {
-        j[key_to_string(key)] = value;
-    }
-    std::ofstream file(output_dir + filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file for writing JSON.");
-    }
-    file << j.dump(4);
-    file.close();
-}
-
-// Specialized serialization for pair<tuple<int, int, bool>, bool> keys
-template <typename Value, typename Hash>
-void serialize_to_json(const std::unordered_map<std::pair<std::tuple<int, int, bool>, bool>, Value, Hash>& map,
-                       const std::string& filename) {
-    nlohmann::json j;
-    for (const auto& [key, value] : map) {
-        const auto& [state, action] = key;
-        const auto& [a, b, c] = state;
-        j["(" + key_to_string(a) + "," + key_to_string(b) + "," + (c ? "true" : "false") + ")," +
-          (action ? "hit" : "stick")] = value;
-    }
-    std::ofstream file(output_dir + filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file for writing JSON.");
+        to_text(key, key_text);
+        writer.member(key_text, value);
     }
-    file << j.dump(4);
-    file.close();
+    writer.end_object();
+    writer.close();
 }
 
-// Specialized serialization for TagGame state-action pair
-template <typename Value, typename Hash>
-void serialize_to_json(
-    const std::unordered_map<std::pair<std::tuple<std::pair<int, int>, std::pair<int, int>, int>, std::pair<int, int>>,
-                             Value, Hash>& map,
-    const std::string& filename) {
-    nlohmann::json j;
-    for (const auto& [key, value] : map) {
-        const auto& [state, action] = key;
-        const auto& [vec1, vec2, integer] = state;
-
-        std::string key_string = "([" + std::to_string(vec1.first) + ", " + std::to_string(vec1.second) + "], " + "[" +
-                                 std::to_string(vec2.first) + ", " + std::to_string(vec2.second) + "], " +
-                                 std::to_string(integer) + "), " + "(" + std::to_string(action.first) + ", " +
-                                 std::to_string(action.second) + ")";
-
-        j[key_string] = value;
-    }
-
-    std::ofstream file(output_dir + filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file for writing JSON.");
+template <typename State, typename Action>
+bool save_q_values(const TabularValueStrategy<State, Action>& strategy, const std::string& file_path) {
+    try {
+        serialize_to_json(strategy.get_Q(), file_path);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to save Q values: " << e.what() << std::endl;
+        return false;
     }
-
-    file << j.dump(4);
-    file.close();
 }
 
 template <typename State, typename Action>
-bool save_q_values(TabularValueStrategy<State, Action>& strategy, const std::string& file_path) {
+bool save_q_values(const IndexedTabularValueStrategy<State, Action>& strategy, const std::string& file_path) {
     try {
-        serialize_to_json(strategy.get_Q(), file_path);
+        serialize_to_json(strategy.get_Q().to_map(), file_path);
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Failed to save Q values: " << e.what() << std::endl;
@@ -159,26 +70,16 @@ bool save_v_values(TabularValueStrategy<State, Action>& strategy, const std::str
     }
 }
 
-// Generic load function for Q values - must be specialized for different State/Action types
 template <typename State, typename Action>
 bool load_q_values(TabularValueStrategy<State, Action>& strategy, const std::string& file_path) {
-    // Base implementation for simple cases, should be specialized for complex types
     try {
         if (!std::filesystem::exists(file_path)) return false;
 
-        std::ifstream q_input(file_path);
-        nlohmann::json q_data;
-        q_input >> q_data;
-
-        for (const auto& [key_str, value] : q_data.items()) {
-            // For simple cases where we can parse the key directly
-            // This should be specialized for complex State/Action types
-            std::cerr << "Warning: Using default parser for key: " << key_str << std::endl;
-            State state;
-            Action action;
-            // Default implementation can't parse complex keys
+        JsonObjectReader reader([&](const std::string& key, Return value) {
+            auto [state, action] = from_text<std::pair<State, Action>>(key);
             strategy.set_q(state, action, value);
-        }
+        });
+        parse_json_file(file_path, reader);
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Failed to load Q values: " << e.what() << std::endl;
@@ -186,25 +87,13 @@ bool load_q_values(TabularValueStrategy<State, Action>& strategy, const std::str
     }
 }
 
-// Generic load function for V values - must be specialized for different State types
 template <typename State, typename Action>
 bool load_v_values(TabularValueStrategy<State, Action>& strategy, const std::string& file_path) {
-    // Base implementation for simple cases, should be specialized for complex types
     try {
         if (!std::filesystem::exists(file_path)) return false;
 
-        std::ifstream v_input(file_path);
-        nlohmann::json v_data;
-        v_input >> v_data;
-
-        for (const auto& [key_str, value] : v_data.items()) {
-            // For simple cases where we can parse the key directly
-            // This should be specialized for complex State types
-            std::cerr << "Warning: Using default parser for key: " << key_str << std::endl;
-            State state;
-            // Default implementation can't parse complex keys
-            strategy.set_v(state, value);
-        }
+        JsonObjectReader reader([&](const std::string& key, Return value) { strategy.set_v(from_text<State>(key), value); });
+        parse_json_file(file_path, reader);
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Failed to load V values: " << e.what() << std::endl;
@@ -212,30 +101,110 @@ bool load_v_values(TabularValueStrategy<State, Action>& strategy, const std::str
     }
 }
 
-// Specialization for TagGame Q-values
-template <>
-inline bool load_q_values<std::tuple<std::pair<int, int>, std::pair<int, int>, int>, std::pair<int, int>>(
-    TabularValueStrategy<std::tuple<std::pair<int, int>, std::pair<int, int>, int>, std::pair<int, int>>& strategy,
-    const std::string& file_path) {
-    using State = std::tuple<std::pair<int, int>, std::pair<int, int>, int>;
-    using Action = std::pair<int, int>;
+// Only visited keys are written: {"table_size": N, "actions": [...], "q": {"<key>": [Q per action]}}
+template <typename State, typename Action, typename Discretizer>
+bool save_q_values(DiscretizedValueStrategy<State, Action, Discretizer>& strategy, const std::string& file_path) {
+    try {
+        JsonWriter writer(output_dir + file_path);
+        writer.begin_object();
+        writer.member("table_size", strategy.table_size());
+        writer.member("actions", strategy.actions());
+
+        writer.key("q").begin_object();
+        const size_t n_actions = strategy.actions().size();
+        for (size_t key = 0; key < strategy.table_size(); key++) {
+            if (!strategy.visited(key)) continue;
+            const Return* values = strategy.values(key);
+            writer.key(std::to_string(key)).begin_array();
+            for (size_t i = 0; i < n_actions; i++) writer.value(values[i]);
+            writer.end_array();
+        }
+        writer.end_object();
 
-    if (!std::filesystem::exists(file_path)) return false;
+        writer.end_object();
+        writer.close();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to save Q values: " << e.what() << std::endl;
+        return false;
+    }
+}
 
-    try {
-        std::ifstream q_input(file_path);
-        nlohmann::json q_data;
-        q_input >> q_data;
+// Reads the save_q_values format for DiscretizedValueStrategy one event at a time.
+// The action list is checked before any Q values are written (nlohmann-sorted and
+// streamed files both put "actions" before "q"); table_size is checked at the end.
+template <typename State, typename Action, typename Discretizer>
+class DiscretizedQReader : public JsonSaxHandler {
+   private:
+    using ActionCodec = FlatCodec<Action>;
+
+    DiscretizedValueStrategy<State, Action, Discretizer>& m_strategy;
+    std::string m_section;  // current top-level member
+    std::string m_key;      // current member of "q"
+    std::vector<int32_t> m_action_words;
+    std::vector<Return> m_values;
+    bool m_actions_checked{false};
+    size_t m_table_size{0};
+
+    bool number(double value) {
+        if (m_section == "table_size" && m_depth == 1) m_table_size = static_cast<size_t>(value);
+        if (m_section == "actions" && m_depth >= 2) m_action_words.push_back(static_cast<int32_t>(value));
+        if (m_section == "q" && m_depth == 3) m_values.push_back(value);
+        return true;
+    }
 
-        for (const auto& [state_action_str, value] : q_data.items()) {
-            State state;
-            Action action;
+    void check_actions() {
+        const auto& actions = m_strategy.actions();
+        std::vector<int32_t> expected(actions.size() * ActionCodec::WIDTH);
+        for (size_t i = 0; i < actions.size(); i++) ActionCodec::encode(actions[i], &expected[i * ActionCodec::WIDTH]);
+        if (m_action_words != expected) throw std::runtime_error("action set differs from the file");
+        m_actions_checked = true;
+    }
 
-            sscanf(state_action_str.c_str(), "([%d, %d], [%d, %d], %d), (%d, %d)", &std::get<0>(std::get<0>(state)),
-                   &std::get<1>(std::get<0>(state)), &std::get<0>(std::get<1>(state)), &std::get<1>(std::get<1>(state)),
-                   &std::get<2>(state), &std::get<0>(action), &std::get<1>(action));
+    void store_entry() {
+        if (!m_actions_checked) throw std::runtime_error("Q values appear before the action set");
+        size_t key = std::stoul(m_key);
+        if (key >= m_strategy.table_size() || m_values.size() != m_strategy.actions().size()) {
+            throw std::runtime_error("invalid entry for key " + m_key);
+        }
+        std::copy(m_values.begin(), m_values.end(), m_strategy.values(key));
+        m_strategy.mark_visited(key);
+        m_values.clear();
+    }
 
-            strategy.set_q(state, action, value);
+   public:
+    explicit DiscretizedQReader(DiscretizedValueStrategy<State, Action, Discretizer>& strategy)
+        : m_strategy(strategy) {}
+
+    bool key(string_t& k) override {
+        if (m_depth == 1) m_section = k;
+        if (m_depth == 2 && m_section == "q") m_key = k;
+        return true;
+    }
+    bool boolean(bool v) override { return number(v); }
+    bool number_integer(number_integer_t v) override { return number(v); }
+    bool number_unsigned(number_unsigned_t v) override { return number(v); }
+    bool number_float(number_float_t v, const string_t&) override { return number(v); }
+    bool end_array() override {
+        JsonSaxHandler::end_array();
+        if (m_section == "actions" && m_depth == 1) check_actions();
+        if (m_section == "q" && m_depth == 2) store_entry();
+        return true;
+    }
+
+    size_t table_size() const { return m_table_size; }
+};
+
+template <typename State, typename Action, typename Discretizer>
+bool load_q_values(DiscretizedValueStrategy<State, Action, Discretizer>& strategy, const std::string& file_path) {
+    try {
+        if (!std::filesystem::exists(file_path)) return false;
+
+        DiscretizedQReader<State, Action, Discretizer> reader(strategy);
+        parse_json_file(file_path, reader);
+        if (reader.table_size() != strategy.table_size()) {
+            std::cerr << "Failed to load Q values: discretization differs from " << file_path << std::endl;
+            return false;
         }
         return true;
     } catch (const std::exception& e) {
@@ -244,25 +213,14 @@ inline bool load_q_values<std::tuple<std::pair<int, int>, std::pair<int, int>, i
     }
 }
 
-template <typename State, typename Action>
-bool save_approximator(const FunctionApproximator<State, Action>* approximator, const std::string& file_path) {
+// Writes {"weights": [...]}, the format load_approximator reads
+inline bool save_weights(const std::vector<double>& weights, const std::string& file_path) {
     try {
-        if (!approximator) {
-            std::cerr << "Error: Null approximator pointer" << std::endl;
-            return false;
-        }
-
-        const auto& weights = approximator->get_weights();
-
-        nlohmann::json j;
-        j["weights"] = weights;
-
-        std::ofstream file(output_dir + file_path);
-        if (!file.is_open()) {
-            throw std::runtime_error("Failed to open file for writing JSON.");
-        }
-        file << j.dump(4);
-        file.close();
+        JsonWriter writer(output_dir + file_path);
+        writer.begin_object();
+        writer.member("weights", weights);
+        writer.end_object();
+        writer.close();
 
         return true;
     } catch (const std::exception& e) {
@@ -271,6 +229,15 @@ bool save_approximator(const FunctionApproximator<State, Action>* approximator,
     }
 }
 
+template <typename State, typename Action>
+bool save_approximator(const FunctionApproximator<State, Action>* approximator, const std::string& file_path) {
+    if (!approximator) {
+        std::cerr << "Error: Null approximator pointer" << std::endl;
+        return false;
+    }
+    return save_weights(approximator->get_weights(), file_path);
+}
+
 template <typename State, typename Action>
 bool load_approximator(FunctionApproximator<State, Action>* approximator, const std::string& file_path) {
     try {
@@ -284,13 +251,26 @@ bool load_approximator(FunctionApproximator<State, Action>* approximator, const
             return false;
         }
 
-        std::ifstream input_file(file_path);
-        nlohmann::json j;
-        input_file >> j;
-
-        std::vector<double> weights = j["weights"].get<std::vector<double>>();
-
-        approximator->set_weights(weights);
+        // {"weights": [...]}: collect the numbers of the top-level "weights" array
+        struct WeightsReader : JsonSaxHandler {
+            std::string section;
+            std::vector<double> weights;
+
+            bool key(string_t& k) override {
+                if (m_depth == 1) section = k;
+                return true;
+            }
+            bool number(double v) {
+                if (m_depth == 2 && section == "weights") weights.push_back(v);
+                return true;
+            }
+            bool number_integer(number_integer_t v) override { return number(v); }
+            bool number_unsigned(number_unsigned_t v) override { return number(v); }
+            bool number_float(number_float_t v, const string_t&) override { return number(v); }
+        } reader;
+        parse_json_file(file_path, reader);
+
+        approximator->set_weights(reader.weights);
 
         return true;
     } catch (const std::exception& e) {
@@ -303,17 +283,14 @@ bool load_approximator(FunctionApproximator<State, Action>* approximator, const
 inline void serialize_blackjack_policy(
     const std::unordered_map<std::tuple<int, int, bool>, bool, StateHash<std::tuple<int, int, bool>>>& policy,
     const std::string& filename) {
-    nlohmann::json j;
+    JsonWriter writer(output_dir + filename);
+    writer.begin_object();
     for (const auto& [state, action] : policy) {
         // For Blackjack: true = "hit", false = "stick"
-        j[key_to_string(state)] = action ? "hit" : "stick";
+        writer.member(key_to_string(state), action ? "hit" : "stick");
     }
-    std::ofstream file(output_dir + filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file for writing JSON.");
-    }
-    file << j.dump(4);
-    file.close();
+    writer.end_object();
+    writer.close();
 }
 
 // Generic policy serialization for non-boolean actions
@@ -321,14 +298,11 @@ template <typename State, typename Action>
 typename std::enable_if<!std::is_same<Action, bool>::value && !std::is_same<Action, double>::value, void>::type
 serialize_policy_to_json(const std::unordered_map<State, Action, StateHash<State>>& policy,
                          const std::string& filename) {
-    nlohmann::json j;
+    JsonWriter writer(output_dir + filename);
+    writer.begin_object();
     for (const auto& [state, action] : policy) {
-        j[key_to_string(state)] = action;
-    }
-    std::ofstream file(output_dir + filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file for writing JSON.");
+        writer.member(key_to_string(state), action);
     }
-    file << j.dump(4);
-    file.close();
+    writer.end_object();
+    writer.close();
 }
@@ -1,47 +1,53 @@
 package taggame;
 
-import java.io.*;
-import java.net.*;
+import java.io.IOException;
 
+// Talks to the RL agent over the transport chosen with -Dtaggame.transport:
+// tcp (the default, port 12345), unix (a Unix domain socket) or shm (shared
+// memory, same host only). -Dtaggame.transport.path overrides the socket or
+// shared memory file path. The agent must use the same TransportKind.
 public class Communicator {
     public static final String RESET = "reset";
     public static final String EXIT = "exit";
     protected static final int SERVER_PORT = 12345;
-    protected final ServerSocket serverSocket;
-    protected final Socket clientSocket;
-    protected final BufferedReader in;
-    protected final PrintWriter out;
+    protected static final String DEFAULT_SOCKET_PATH = "/tmp/taggame.sock";
+    protected static final String DEFAULT_SHM_PATH = "/dev/shm/taggame";
+    protected final Transport transport;
+    protected boolean verbose = true;
 
     public Communicator() throws IOException {
-        serverSocket = new ServerSocket(SERVER_PORT);
-        System.out.println("Waiting for a client to connect...");
-        clientSocket = serverSocket.accept();
-        System.out.println("Client connected.");
-        in = new BufferedReader(new InputStreamReader(clientSocket.getInputStream()));
-        out = new PrintWriter(clientSocket.getOutputStream(), true);
+        String kind = System.getProperty("taggame.transport", "tcp");
+        String path = System.getProperty("taggame.transport.path");
+        transport = switch (kind) {
+            case "tcp" -> SocketTransport.tcp(SERVER_PORT);
+            case "unix" -> SocketTransport.unix(path != null ? path : DEFAULT_SOCKET_PATH);
+            case "shm" -> SharedMemoryTransport.create(path != null ? path : DEFAULT_SHM_PATH);
+            default -> throw new IOException("Unknown transport " + kind + ", use tcp, unix or shm");
+        };
     }
 
     public String receiveAction() throws IOException {
 //        System.out.println("Waiting for action...");
-        String action = in.readLine();
+        String action = transport.receive();
         if (action == null) {
 //            System.out.println("Connection closed by client.");
             throw new IOException("Connection closed by client.");
         }
-        System.out.println("Received action: " + action);
+        if (verbose) System.out.println("Received action: " + action);
         return action;
     }
 
-    public void sendState(String state) {
-        System.out.println("Sending state to RL agent: " + state);
-        out.println(state);
+    public void sendState(String state) throws IOException {
+        if (verbose) System.out.println("Sending state to RL agent: " + state);
+        transport.send(state);
+    }
+
+    public void setVerbose(boolean verbose) {
+        this.verbose = verbose;
     }
 
     public void close() throws IOException {
-        if (in != null) in.close();
-        if (out != null) out.close();
-        if (clientSocket != null) clientSocket.close();
-        if (serverSocket != null) serverSocket.close();
+        transport.close();
         System.out.println("Server shut down.");
     }
 }
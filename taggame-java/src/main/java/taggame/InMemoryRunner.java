@@ -1,27 +1,36 @@
 package taggame;
 
+// Headless fast-forward runner: no rendering, a fixed simulated timestep and a
+// simulated clock, so the game runs as fast as the RL agent steps it and a run
+// is reproducible for a given seed. Pass the seed as the first argument
+// (-Dtaggame.seed works too) and -Dtaggame.verbose=true to log the exchange.
 public class InMemoryRunner {
     protected static final String RL_PLAYER_NAME = "Sili";
     protected static final int PLAYER_COUNT = 2;
-    protected static final float PLAYER_RADIUS = 20;
-    protected static final int WIDTH = 1000;
-    protected static final int HEIGHT = 1000;
+    protected static final float PLAYER_RADIUS = 10;
+    protected static final int WIDTH = 800;
+    protected static final int HEIGHT = 800;
     protected final static float TIME_COEFFICIENT = 1f;
-    protected static final int MAX_VELOCITY = 10;
-    protected static final int TAGGER_SLEEP_TIME_MS = 50;
+    protected static final float MAX_VELOCITY = 1;
+    protected static final int TAGGER_SLEEP_TIME_MS = 1000;
+    protected static final int TICK_MS = 16;
 
     public static void main(String[] args) {
         TagGame arena = new TagGame(RL_PLAYER_NAME, PLAYER_COUNT, PLAYER_RADIUS, WIDTH, HEIGHT, TIME_COEFFICIENT, MAX_VELOCITY, TAGGER_SLEEP_TIME_MS);
-        arena.initGame();
+        arena.useSimulatedClock();
+        arena.getCommunicator().setVerbose(Boolean.getBoolean("taggame.verbose"));
 
-        long lastTime = System.nanoTime();
+        String seed = args.length > 0 ? args[0] : System.getProperty("taggame.seed");
+        if (seed != null) arena.setSeed(Long.parseLong(seed));
 
-        while (true) {
-            long currentTime = System.nanoTime();
-            long deltaTime = currentTime - lastTime;
-            lastTime = currentTime;
+        arena.initGame();
 
-            arena.updateGame((int) Math.max(deltaTime / 1_000_000L, 1));
+        try {
+            while (true) {
+                arena.updateGame(TICK_MS);
+            }
+        } catch (RuntimeException e) {
+            System.out.println("Game stopped: " + e.getMessage());
         }
     }
 }
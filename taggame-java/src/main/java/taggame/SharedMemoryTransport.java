@@ -0,0 +1,178 @@
+package taggame;
+
+import java.io.IOException;
+import java.io.InterruptedIOException;
+import java.io.RandomAccessFile;
+import java.lang.invoke.MethodHandles;
+import java.lang.invoke.VarHandle;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.function.BooleanSupplier;
+
+// The game's side of SharedMemoryTransport in taggame/Transport.h, which describes
+// the file layout: one single-producer, single-consumer ring per direction in a
+// memory-mapped file. Positions are read with acquire and written with release
+// accesses, so a message's bytes are visible before its position is. A waiting side
+// spins, then yields, then sleeps between polls once the agent has been idle a while.
+// When an agent asks to attach, the rings are emptied before it is let in; when one
+// disconnects, the game waits for the next.
+public class SharedMemoryTransport implements Transport {
+    protected static final int MAGIC = 0x4d534c52;
+    protected static final int VERSION = 2;
+    protected static final int DEFAULT_CAPACITY = 1 << 16;
+    protected static final int LINE = 64;
+    protected static final int CAPACITY_OFFSET = 8;
+    protected static final int GAME_CLOSED_OFFSET = 16;
+    protected static final int AGENT_CLOSED_OFFSET = 24;
+    protected static final int ATTACH_OFFSET = 32;
+    protected static final int ATTACHED_OFFSET = 40;
+    protected static final int HEADER_SIZE = LINE;
+    protected static final int RING_HEADER_SIZE = 2 * LINE;
+    protected static final int SPIN_ITERATIONS = 10000;
+    protected static final long IDLE_BEFORE_SLEEP_NS = 100_000_000L;
+
+    private static final VarHandle INTS = MethodHandles.byteBufferViewVarHandle(int[].class, ByteOrder.nativeOrder());
+    private static final VarHandle LONGS = MethodHandles.byteBufferViewVarHandle(long[].class, ByteOrder.nativeOrder());
+
+    protected final MappedByteBuffer buffer;
+    protected final int capacity;
+    protected final int inRing;   // agent to game
+    protected final int outRing;  // game to agent
+    protected final byte[] lengthBytes = new byte[4];
+    protected final ByteBuffer length = ByteBuffer.wrap(lengthBytes).order(ByteOrder.nativeOrder());
+    protected boolean agentConnected = false;
+
+    protected SharedMemoryTransport(MappedByteBuffer buffer, int capacity) {
+        this.buffer = buffer;
+        this.capacity = capacity;
+        this.inRing = HEADER_SIZE;
+        this.outRing = HEADER_SIZE + RING_HEADER_SIZE + capacity;
+    }
+
+    public static SharedMemoryTransport create(String path) throws IOException {
+        return create(path, DEFAULT_CAPACITY);
+    }
+
+    // Replaces any file left at `path`, so an agent still mapping an old one does not see this session
+    public static SharedMemoryTransport create(String path, int capacity) throws IOException {
+        if (capacity <= 0 || Integer.bitCount(capacity) != 1) {
+            throw new IllegalArgumentException("Ring capacity must be a power of two.");
+        }
+        long size = HEADER_SIZE + 2L * (RING_HEADER_SIZE + capacity);
+        Files.deleteIfExists(Path.of(path));
+
+        MappedByteBuffer buffer;
+        try (RandomAccessFile file = new RandomAccessFile(path, "rw")) {
+            file.setLength(size);
+            buffer = file.getChannel().map(FileChannel.MapMode.READ_WRITE, 0, size);
+        }
+        buffer.order(ByteOrder.nativeOrder());
+        buffer.putLong(CAPACITY_OFFSET, capacity);
+        buffer.putInt(4, VERSION);
+        // The magic goes last, so an agent never sees a half-initialized file as valid
+        INTS.setRelease(buffer, 0, MAGIC);
+
+        System.out.println("Waiting for a client on shared memory " + path + "...");
+        return new SharedMemoryTransport(buffer, capacity);
+    }
+
+    // Empties the rings for the agent that asked to attach, then lets it in
+    protected void acceptAgent(long request) {
+        for (int ring : new int[] {inRing, outRing}) {
+            LONGS.setOpaque(buffer, ring, 0L);
+            LONGS.setOpaque(buffer, ring + LINE, 0L);
+        }
+        LONGS.setOpaque(buffer, AGENT_CLOSED_OFFSET, 0L);
+        LONGS.setRelease(buffer, ATTACHED_OFFSET, request);
+        agentConnected = true;
+        System.out.println("Client connected.");
+    }
+
+    // Waits until ready holds; false if a new agent attached meanwhile, which resets the rings
+    protected boolean await(BooleanSupplier ready) throws IOException {
+        for (int i = 0; i < SPIN_ITERATIONS; i++) {
+            if (ready.getAsBoolean()) return true;
+            Thread.onSpinWait();
+        }
+        long idleSince = System.nanoTime();
+        while (!ready.getAsBoolean()) {
+            long request = (long) LONGS.getAcquire(buffer, ATTACH_OFFSET);
+            if (request != (long) LONGS.getOpaque(buffer, ATTACHED_OFFSET)) {
+                acceptAgent(request);
+                return false;
+            }
+            if (agentConnected && (long) LONGS.getAcquire(buffer, AGENT_CLOSED_OFFSET) != 0) {
+                agentConnected = false;
+                System.out.println("Client disconnected, waiting for a client...");
+            }
+            if (System.nanoTime() - idleSince < IDLE_BEFORE_SLEEP_NS) {
+                Thread.yield();
+            } else {
+                try {
+                    Thread.sleep(1);
+                } catch (InterruptedException e) {
+                    Thread.currentThread().interrupt();
+                    throw new InterruptedIOException("Interrupted while waiting for the client.");
+                }
+            }
+        }
+        return true;
+    }
+
+    protected void copyIn(int ring, long position, byte[] bytes, int size) {
+        int offset = (int) (position & (capacity - 1));
+        int first = Math.min(size, capacity - offset);
+        int data = ring + RING_HEADER_SIZE;
+        buffer.put(data + offset, bytes, 0, first);
+        buffer.put(data, bytes, first, size - first);
+    }
+
+    protected void copyOut(int ring, long position, byte[] bytes, int size) {
+        int offset = (int) (position & (capacity - 1));
+        int first = Math.min(size, capacity - offset);
+        int data = ring + RING_HEADER_SIZE;
+        buffer.get(data + offset, bytes, 0, first);
+        buffer.get(data, bytes, first, size - first);
+    }
+
+    @Override
+    public String receive() throws IOException {
+        while (true) {
+            long position = (long) LONGS.getOpaque(buffer, inRing + LINE);
+            // A new agent attached, its ring starts over
+            if (!await(() -> (long) LONGS.getAcquire(buffer, inRing) != position)) continue;
+
+            copyOut(inRing, position, lengthBytes, 4);
+            int size = length.getInt(0);
+            byte[] message = new byte[size];
+            copyOut(inRing, position + 4, message, size);
+            LONGS.setRelease(buffer, inRing + LINE, position + 4 + size);
+            return new String(message, StandardCharsets.UTF_8);
+        }
+    }
+
+    @Override
+    public void send(String message) throws IOException {
+        byte[] bytes = message.getBytes(StandardCharsets.UTF_8);
+        long size = 4L + bytes.length;
+        if (size > capacity) throw new IOException("Message larger than the shared memory ring.");
+
+        long position = (long) LONGS.getOpaque(buffer, outRing);
+        // A new agent replaced the one this message was for
+        if (!await(() -> position + size - (long) LONGS.getAcquire(buffer, outRing + LINE) <= capacity)) return;
+        length.putInt(0, bytes.length);
+        copyIn(outRing, position, lengthBytes, 4);
+        copyIn(outRing, position + 4, bytes, bytes.length);
+        LONGS.setRelease(buffer, outRing, position + size);
+    }
+
+    @Override
+    public void close() {
+        LONGS.setRelease(buffer, GAME_CLOSED_OFFSET, 1L);
+    }
+}
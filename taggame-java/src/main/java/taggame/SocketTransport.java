@@ -0,0 +1,71 @@
+package taggame;
+
+import java.io.*;
+import java.net.*;
+import java.nio.channels.Channels;
+import java.nio.channels.ServerSocketChannel;
+import java.nio.channels.SocketChannel;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+
+// Newline-framed messages over a TCP or Unix domain socket, one write per message
+public class SocketTransport implements Transport {
+    protected final Closeable server;
+    protected final Closeable client;
+    protected final Path socketPath;  // Unix domain sockets only, removed on close
+    protected final BufferedReader in;
+    protected final Writer out;
+
+    protected SocketTransport(Closeable server, Closeable client, Path socketPath, InputStream in, OutputStream out) {
+        this.server = server;
+        this.client = client;
+        this.socketPath = socketPath;
+        this.in = new BufferedReader(new InputStreamReader(in, StandardCharsets.UTF_8));
+        this.out = new BufferedWriter(new OutputStreamWriter(out, StandardCharsets.UTF_8));
+    }
+
+    public static SocketTransport tcp(int port) throws IOException {
+        ServerSocket serverSocket = new ServerSocket(port);
+        System.out.println("Waiting for a client to connect on port " + port + "...");
+        Socket clientSocket = serverSocket.accept();
+        // Every message is one small write answered by the other side, so Nagle's algorithm only adds delay
+        clientSocket.setTcpNoDelay(true);
+        System.out.println("Client connected.");
+        return new SocketTransport(serverSocket, clientSocket, null,
+                clientSocket.getInputStream(), clientSocket.getOutputStream());
+    }
+
+    public static SocketTransport unix(String path) throws IOException {
+        Path socketPath = Path.of(path);
+        Files.deleteIfExists(socketPath);
+        ServerSocketChannel serverChannel = ServerSocketChannel.open(StandardProtocolFamily.UNIX);
+        serverChannel.bind(UnixDomainSocketAddress.of(socketPath));
+        System.out.println("Waiting for a client to connect on " + path + "...");
+        SocketChannel clientChannel = serverChannel.accept();
+        System.out.println("Client connected.");
+        return new SocketTransport(serverChannel, clientChannel, socketPath,
+                Channels.newInputStream(clientChannel), Channels.newOutputStream(clientChannel));
+    }
+
+    @Override
+    public String receive() throws IOException {
+        return in.readLine();
+    }
+
+    @Override
+    public void send(String message) throws IOException {
+        out.write(message);
+        out.write('\n');
+        out.flush();
+    }
+
+    @Override
+    public void close() throws IOException {
+        in.close();
+        out.close();
+        client.close();
+        server.close();
+        if (socketPath != null) Files.deleteIfExists(socketPath);
+    }
+}
@@ -26,6 +26,9 @@ public class TagGame {
     protected double tagChangedTime;
     protected String rl_player_name;
 
+    protected boolean simulatedClock;
+    protected double simulatedTimeMS;
+
     protected Random rand;
 
     public TagGame(String rl_player_name, int player_count, double player_radius,
@@ -41,7 +44,7 @@ public class TagGame {
         this.taggerSleepTimeMS = taggerSleepTimeMS;
 
         this.players = new ArrayList<>();
-        this.tagChangedTime = 0;
+        this.tagChangedTime = Double.NEGATIVE_INFINITY;
         this.tagPlayer = null;
         this.maxVelocity = maxVelocity;
         this.rand = new Random();
@@ -56,7 +59,7 @@ public class TagGame {
     public void initGame() {
         players.clear();
         tagPlayer = null;
-        this.tagChangedTime = 0;
+        this.tagChangedTime = Double.NEGATIVE_INFINITY;
 
         for (int i = 0; i < player_count; i++) {
             TagPlayer player = new TagPlayer(
@@ -90,25 +93,25 @@ public class TagGame {
             String action = communicator.receiveAction();
             if (action == null || action.equalsIgnoreCase(Communicator.EXIT)) return;
 
+            int repeat = 1;
             if (action.equals(Communicator.RESET)) {
                 initGame();
             } else {
                 RL_player.setSteeringBehavior((StaticInfo staticInfo, Vector2D currentVelocity) ->
                         deserializeAction(action));
+                repeat = deserializeRepeat(action);
             }
 
-            boolean taggerSleeping = System.currentTimeMillis() - tagChangedTime < this.taggerSleepTimeMS;
-            if (!taggerSleeping) {
-                tagPlayer.setSteeringBehavior(new DumbTagSteering(tagPlayer, this, width, height, (float) (this.maxVelocity * 0.8f)));
-                handleTaggingLogic();
-            }
-
-            for (TagPlayer player : players) {
-                player.update(time * this.time_coefficient);
-            }
+            // An action may ask for several ticks; stop early once the RL player is tagged
+            int ticks = 0;
+            do {
+                tick(time);
+                ticks++;
+            } while (ticks < repeat && tagPlayer != getRLPlayer());
 
-            var serializedState = getSerializedGameState(players.get(RL_PLAYER_INDEX)).toString();
-            communicator.sendState(serializedState);
+            var serializedState = getSerializedGameState(players.get(RL_PLAYER_INDEX));
+            if (repeat > 1) serializedState.put("n", ticks);
+            communicator.sendState(serializedState.toString());
         } catch (IOException e) {
             try {
                 communicator.close();
@@ -119,6 +122,39 @@ public class TagGame {
         }
     }
 
+    protected void tick(int time) {
+        boolean taggerSleeping = currentTimeMS() - tagChangedTime < this.taggerSleepTimeMS;
+        if (!taggerSleeping) {
+            tagPlayer.setSteeringBehavior(new DumbTagSteering(tagPlayer, this, width, height, (float) (this.maxVelocity * 0.8f)));
+            handleTaggingLogic();
+        }
+
+        for (TagPlayer player : players) {
+            player.update(time * this.time_coefficient);
+        }
+
+        if (simulatedClock) simulatedTimeMS += time;
+    }
+
+    // Advance time only by the `time` passed to updateGame instead of the wall clock,
+    // so the tagger sleep no longer depends on how fast the RL agent answers.
+    public void useSimulatedClock() {
+        this.simulatedClock = true;
+        this.simulatedTimeMS = 0;
+    }
+
+    public void setSeed(long seed) {
+        this.rand = new Random(seed);
+    }
+
+    public Communicator getCommunicator() {
+        return communicator;
+    }
+
+    protected double currentTimeMS() {
+        return simulatedClock ? simulatedTimeMS : System.currentTimeMillis();
+    }
+
     public List<TagPlayer> getPlayers() {
         return players;
     }
@@ -141,6 +177,10 @@ public class TagGame {
         double y = json.getInt("y");
         return new Vector2D(x, y);
     }
+
+    protected int deserializeRepeat(String action) {
+        return Math.max(1, new JSONObject(action).optInt("k", 1));
+    }
     protected JSONObject getSerializedGameState(TagPlayer me) {
         JSONObject gameState = new JSONObject();
 
@@ -164,7 +204,7 @@ public class TagGame {
             if (player != tagPlayer && tagPlayer.isTagging(player)) {
                 setTag(player);
                 tagPlayer.setSteeringBehavior(TagPlayer.idleSteering);
-                tagChangedTime = System.currentTimeMillis();
+                tagChangedTime = currentTimeMS();
                 return;
             }
         }
@@ -0,0 +1,14 @@
+package taggame;
+
+import java.io.IOException;
+
+// Carries newline-free messages between the game and the RL agent. Matches the
+// agent's transport in taggame/Transport.h, selected with -Dtaggame.transport.
+public interface Transport {
+    // The next message from the agent, or null once the agent has disconnected
+    String receive() throws IOException;
+
+    void send(String message) throws IOException;
+
+    void close() throws IOException;
+}
@@ -1,16 +1,20 @@
-#include <arpa/inet.h>
-#include <netinet/in.h>
-#include <sys/socket.h>
-#include <unistd.h>
+#pragma once
 
-#include <cerrno>
 #include <csignal>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
 
+#include "taggame/Transport.h"
+
 class Communicator {
    public:
     const std::string RESET = "reset";
+    // Line prefixes of a traffic trace: messages sent to the server, and its replies
+    static inline const std::string TRACE_SENT = "> ";
+    static inline const std::string TRACE_RECEIVED = "< ";
 
     static Communicator& getInstance() {
         static Communicator instance;
@@ -18,63 +22,77 @@ class Communicator {
     }
 
     bool connectToServer(const std::string& host, int port) {
-        sock = socket(AF_INET, SOCK_STREAM, 0);
-        if (sock < 0) {
-            std::cerr << "Socket creation failed." << std::endl;
-            return false;
-        }
-
-        sockaddr_in serverAddr{};
-        serverAddr.sin_family = AF_INET;
-        serverAddr.sin_port = htons(port);
-        inet_pton(AF_INET, host.c_str(), &serverAddr.sin_addr);
+        TransportConfig config;
+        config.host = host;
+        config.port = port;
+        return connect(config);
+    }
 
-        if (connect(sock, (sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
-            std::cerr << "Connection to server failed." << std::endl;
-            close(sock);
+    bool connect(const TransportConfig& config) {
+        disconnect();
+        try {
+            transport = open_transport(config);
+        } catch (const std::exception& e) {
+            std::cerr << "Connection to server failed: " << e.what() << std::endl;
             return false;
         }
+        verbose = config.verbose;
 
-        std::cout << "Connected to server at " << host << ":" << port << std::endl;
+        std::cout << "Connected to server over " << transport_description(config) << std::endl;
         return true;
     }
 
     void disconnect() {
-        if (sock >= 0) {
-            close(sock);
-            sock = -1;
+        if (transport) {
+            transport.reset();
             std::cout << "Disconnected from server." << std::endl;
         }
     }
 
+    bool isVerbose() const { return verbose; }
+
+    // Records every message from now on, one per line, for replay without the server
+    bool startTrace(const std::string& file_path) {
+        trace.close();
+        trace.open(file_path, std::ios::trunc);
+        if (!trace.is_open()) {
+            std::cerr << "Failed to open trace file: " << file_path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void stopTrace() { trace.close(); }
+
     std::string receiveState() {
-        char buffer[4096];
-        ssize_t bytesReceived = recv(sock, buffer, sizeof(buffer) - 1, 0);
-        if (bytesReceived > 0) {
-            buffer[bytesReceived] = '\0';
-            return std::string(buffer);
-        } else if (bytesReceived == 0) {
-            std::cerr << "Server closed the connection." << std::endl;
-            throw std::runtime_error("Server closed the connection.");
-        } else {
-            std::cerr << "Error receiving state." << std::endl;
-            throw std::runtime_error("Error receiving state.");
+        if (!transport) throw std::runtime_error("Not connected to the server.");
+        std::string state;
+        try {
+            state = transport->receive();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            throw;
         }
-        return "";
+        if (trace.is_open()) trace << TRACE_RECEIVED << state << '\n';
+        return state;
     }
 
     void sendAction(const std::string& action) {
-        std::string actionWithNewline = action + "\n";  // Add newline for Java `readLine`
-        ssize_t bytesSent = send(sock, actionWithNewline.c_str(), actionWithNewline.size(), 0);
-        std::cout << "Sending " << action << std::endl;
-        if (bytesSent < 0) {
-            std::cerr << "Error sending action." << std::endl;
-            throw std::runtime_error("Error sending action.");
+        if (!transport) throw std::runtime_error("Not connected to the server.");
+        if (verbose) std::cout << "Sending " << action << std::endl;
+        if (trace.is_open()) trace << TRACE_SENT << action << '\n';
+        try {
+            transport->send(action);  // framed with a newline for Java `readLine`
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            throw;
         }
     }
 
    private:
-    int sock = -1;
+    std::unique_ptr<Transport> transport;
+    bool verbose = true;
+    std::ofstream trace;
 
     Communicator() {
         signal(SIGPIPE, SIG_IGN);  // Ignore SIGPIPE globally
@@ -82,4 +100,4 @@ class Communicator {
     Communicator(const Communicator&) = delete;
     Communicator& operator=(const Communicator&) = delete;
     ~Communicator() { disconnect(); }
-};
\ No newline at end of file
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// Bit-exact port of java.util.Random so a seeded simulator draws the same
+// spawn positions as the Java TagGame server started with the same seed.
+class JavaRandom {
+   private:
+    static constexpr uint64_t MULTIPLIER = 0x5DEECE66DULL;
+    static constexpr uint64_t ADDEND = 0xBULL;
+    static constexpr uint64_t MASK = (1ULL << 48) - 1;
+
+    uint64_t m_seed;
+
+    int32_t next(int bits) {
+        m_seed = (m_seed * MULTIPLIER + ADDEND) & MASK;
+        return static_cast<int32_t>(m_seed >> (48 - bits));
+    }
+
+   public:
+    explicit JavaRandom(int64_t seed = 0) { set_seed(seed); }
+
+    void set_seed(int64_t seed) { m_seed = (static_cast<uint64_t>(seed) ^ MULTIPLIER) & MASK; }
+
+    int32_t next_int(int32_t bound) {
+        if ((bound & -bound) == bound) {
+            return static_cast<int32_t>((static_cast<int64_t>(bound) * static_cast<int64_t>(next(31))) >> 31);
+        }
+
+        int32_t bits, value;
+        do {
+            bits = next(31);
+            value = bits % bound;
+        } while (static_cast<int64_t>(bits) - value + (bound - 1) > std::numeric_limits<int32_t>::max());
+        return value;
+    }
+
+    double next_double() {
+        int64_t high = static_cast<int64_t>(next(26)) << 27;
+        return static_cast<double>(high + next(27)) * 0x1.0p-53;
+    }
+};
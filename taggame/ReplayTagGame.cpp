@@ -0,0 +1,146 @@
+#include "ReplayTagGame.h"
+
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+namespace {
+const std::string JAVA_ACTION_PREFIX = "Received action: ";
+const std::string JAVA_STATE_PREFIX = "Sending state to RL agent: ";
+
+// The text after `prefix` if the line contains it
+bool after(const std::string& line, const std::string& prefix, std::string& rest) {
+    auto pos = line.find(prefix);
+    if (pos == std::string::npos) return false;
+    rest = line.substr(pos + prefix.size());
+    return true;
+}
+}  // namespace
+
+std::vector<std::pair<std::string, std::string>> read_taggame_trace(const std::string& file_path) {
+    std::ifstream input(file_path);
+    if (!input.is_open()) {
+        throw std::runtime_error("Failed to open trace file: " + file_path);
+    }
+
+    std::vector<std::pair<std::string, std::string>> exchanges;
+    std::string line, action, state;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.rfind(Communicator::TRACE_SENT, 0) == 0) {
+            action = line.substr(Communicator::TRACE_SENT.size());
+        } else if (line.rfind(Communicator::TRACE_RECEIVED, 0) == 0) {
+            if (!action.empty()) exchanges.emplace_back(action, line.substr(Communicator::TRACE_RECEIVED.size()));
+            action.clear();
+        } else if (after(line, JAVA_ACTION_PREFIX, state)) {
+            action = state;
+        } else if (after(line, JAVA_STATE_PREFIX, state) && !action.empty()) {
+            exchanges.emplace_back(action, state);
+            action.clear();
+        }
+    }
+
+    return exchanges;
+}
+
+void ReplayTagGame::initialize() {
+    initialize_actions();
+
+    m_ticks.clear();
+    m_episode_starts.clear();
+    std::vector<Tick> episode;
+    bool started = false;
+    for (const auto& [action_str, state_str] : read_taggame_trace(m_file_path)) {
+        if (action_str == Communicator::getInstance().RESET) {
+            episode.clear();
+            started = true;
+            episode.push_back({Action{}, parse_state(state_str), 1});
+            continue;
+        }
+        if (!started) continue;
+
+        nlohmann::json action = nlohmann::json::parse(action_str);
+        State state = parse_state(state_str);
+        episode.push_back({{action["x"], action["y"]}, state, nlohmann::json::parse(state_str).value("n", 1)});
+        if (is_terminal(state)) {
+            m_episode_starts.push_back(m_ticks.size());
+            m_ticks.insert(m_ticks.end(), episode.begin(), episode.end());
+            episode.clear();
+            started = false;
+        }
+    }
+
+    if (m_episode_starts.empty()) {
+        throw std::runtime_error("No complete episode to replay in " + m_file_path);
+    }
+    m_next_episode = 0;
+    m_in_episode = false;
+    clear_statistics();
+}
+
+State ReplayTagGame::reset() {
+    m_cursor = m_episode_starts[m_next_episode];
+    m_next_episode = (m_next_episode + 1) % m_episode_starts.size();
+    m_in_episode = true;
+
+    m_timing = true;
+    m_returned = std::chrono::steady_clock::now();
+    return m_ticks[m_cursor].state;
+}
+
+const ReplayTagGame::Tick& ReplayTagGame::advance(const Action& action) {
+    auto now = std::chrono::steady_clock::now();
+    if (!m_in_episode) {
+        throw std::runtime_error("The replayed episode has ended, reset first");
+    }
+    if (m_timing) m_latencies_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_returned).count());
+
+    const Tick& tick = m_ticks[++m_cursor];
+    if (tick.action == action) m_matching_actions++;
+    m_in_episode = !is_terminal(tick.state);
+    return tick;
+}
+
+std::pair<State, Reward> ReplayTagGame::step(const State& old_s, const Action& action) {
+    const Tick& tick = advance(action);
+    Reward reward = calculate_reward(old_s, tick.state);
+
+    m_timing = m_in_episode;
+    m_returned = std::chrono::steady_clock::now();
+    return {tick.state, reward};
+}
+
+std::tuple<State, Reward, TimeStep> ReplayTagGame::step_repeated(const State& old_s, const Action& action, int,
+                                                                 double discount_rate) {
+    const Tick& tick = advance(action);
+    Reward reward = repeated_reward(old_s, tick.state, tick.ticks, discount_rate);
+
+    m_timing = m_in_episode;
+    m_returned = std::chrono::steady_clock::now();
+    return {tick.state, reward, tick.ticks};
+}
+
+double ReplayTagGame::action_agreement() const {
+    return m_latencies_ns.empty() ? 0 : static_cast<double>(m_matching_actions) / m_latencies_ns.size();
+}
+
+double ReplayTagGame::mean_latency_us() const {
+    if (m_latencies_ns.empty()) return 0;
+    double total = 0;
+    for (int64_t ns : m_latencies_ns) total += ns;
+    return total / m_latencies_ns.size() / 1000;
+}
+
+double ReplayTagGame::latency_percentile_us(double p) const {
+    if (m_latencies_ns.empty()) return 0;
+    std::vector<int64_t> sorted = m_latencies_ns;
+    size_t rank = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank] / 1000.0;
+}
+
+void ReplayTagGame::clear_statistics() {
+    m_latencies_ns.clear();
+    m_matching_actions = 0;
+}
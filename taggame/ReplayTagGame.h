@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "taggame/TagGame.h"
+
+// (message sent to the server, its reply) pairs of a recorded session, in order.
+// Reads traces written by TagGame::record_trace ("> " / "< " lines) and the log
+// of taggame-java's Communicator ("Received action: " / "Sending state to RL agent: ").
+std::vector<std::pair<std::string, std::string>> read_taggame_trace(const std::string &file_path);
+
+// TagGame that replays the states of a recorded session instead of talking to the
+// server, so the agent can be run and timed without Java. Steps return the recorded
+// next state whatever the agent chooses; the recorded action is only compared.
+// Only complete episodes (a reset followed by steps up to the tag) are replayed,
+// and the trace starts over after its last episode.
+//
+// Replay itself does no parsing or I/O, so the time between a step's return and
+// the next step is the agent's decision latency. The time between the end of an
+// episode and the next reset is not counted.
+class ReplayTagGame : public TagGameBase {
+   private:
+    struct Tick {
+        Action action;  // unused for resets
+        State state;
+        TimeStep ticks;
+    };
+
+    std::string m_file_path;
+    std::vector<Tick> m_ticks;
+    std::vector<size_t> m_episode_starts;  // index of each episode's reset in m_ticks
+    size_t m_next_episode{0};
+    size_t m_cursor{0};
+    bool m_in_episode{false};
+
+    std::chrono::steady_clock::time_point m_returned;
+    bool m_timing{false};
+    std::vector<int64_t> m_latencies_ns;
+    size_t m_matching_actions{0};
+
+    const Tick &advance(const Action &action);
+
+   public:
+    // `file_path` is the full path of the trace
+    explicit ReplayTagGame(std::string file_path) : TagGameBase(), m_file_path(std::move(file_path)) {}
+    void initialize() override;
+    State reset() override;
+    std::pair<State, Reward> step(const State &, const Action &) override;
+    // The recorded reply says how many ticks ran, so the requested repeat count is not used
+    std::tuple<State, Reward, TimeStep> step_repeated(const State &, const Action &, int, double discount_rate);
+
+    size_t episodes() const { return m_episode_starts.size(); }
+    size_t decisions() const { return m_latencies_ns.size(); }
+    // Fraction of decisions that chose the recorded action
+    double action_agreement() const;
+    double mean_latency_us() const;
+    // p in [0, 1], e.g. 0.99
+    double latency_percentile_us(double p) const;
+    void clear_statistics();
+};
@@ -0,0 +1,35 @@
+#include "SimulatedTagGame.h"
+
+#include <cmath>
+
+namespace {
+// Utils.toIntArray: rounds away from zero
+int to_int(double v) { return static_cast<int>(v < 0 ? std::floor(v) : std::ceil(v)); }
+
+std::pair<int, int> to_int_pair(const Vec2& v) { return {to_int(v.x), to_int(v.y)}; }
+}  // namespace
+
+void SimulatedTagGame::initialize() {
+    m_arena.init_game();
+    initialize_actions();
+}
+
+State SimulatedTagGame::observe() const {
+    const TagPlayer& me = m_arena.rl_player();
+    const TagPlayer& tagger = m_arena.tag_player();
+
+    return {to_int_pair(me.pos), to_int_pair(me.velocity), to_int_pair(tagger.pos), to_int_pair(tagger.velocity),
+            m_arena.rl_player_tagged()};
+}
+
+State SimulatedTagGame::reset() {
+    m_arena.tick(true);
+    return observe();
+}
+
+std::pair<State, Reward> SimulatedTagGame::step(const State& old_s, const Action& action) {
+    m_arena.tick(false, {static_cast<double>(action.first), static_cast<double>(action.second)});
+    State new_s = observe();
+
+    return {new_s, calculate_reward(old_s, new_s)};
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "taggame/TagArena.h"
+#include "taggame/TagGame.h"
+
+// TagGame that runs the arena in-process instead of over the Java socket.
+// Training uses this; the socket-backed TagGame stays for visualization.
+class SimulatedTagGame : public TagGameBase {
+   protected:
+    TagArena m_arena;
+
+    State observe() const;
+
+   public:
+    explicit SimulatedTagGame(const TagGameConfig &config = {}) : TagGameBase(), m_arena(config) {}
+    void initialize() override;
+    void seed(int64_t seed) { m_arena.seed(seed); }
+    State reset() override;
+    std::pair<State, Reward> step(const State &, const Action &) override;
+    const TagArena &arena() const { return m_arena; }
+    void save_state(StateWriter &writer) const { m_arena.save_state(writer); }
+    void load_state(StateReader &reader) { m_arena.load_state(reader); }
+};
@@ -0,0 +1,228 @@
+#include "TagArena.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "StateArchive.h"
+
+TagArena::TagArena(const TagGameConfig& config)
+    : m_config(config),
+      m_tag_player(-1),
+      m_clock_ms(0),
+      m_tag_changed_time(-std::numeric_limits<double>::infinity()),
+      m_rand(config.seed),
+      m_tagger_rand(static_cast<std::mt19937::result_type>(config.seed)) {
+    const double diagonal = std::hypot(m_config.width, m_config.height);
+    m_safe_distance_threshold = 0.2 * diagonal;
+    m_chasing_corner_distance_threshold = 0.2 * diagonal;
+    m_corner_weight_multiplier = 0.3 * diagonal;
+
+    m_corners = {{0, 0},
+                 {0, static_cast<double>(m_config.height)},
+                 {static_cast<double>(m_config.width), 0},
+                 {static_cast<double>(m_config.width), static_cast<double>(m_config.height)}};
+}
+
+void TagArena::seed(int64_t seed) {
+    m_config.seed = seed;
+    m_rand.set_seed(seed);
+    m_tagger_rand.seed(static_cast<std::mt19937::result_type>(seed));
+}
+
+Vec2 TagArena::random_position() {
+    double x = m_rand.next_double() * m_config.width;
+    double y = m_rand.next_double() * m_config.height;
+    return {x, y};
+}
+
+// The Java server picks the initial tagger with its own unseeded Random; with two
+// players the result is always the non-RL player, so only larger games differ.
+int TagArena::random_non_rl_player() {
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(m_players.size()) - 1);
+    int player;
+    do {
+        player = dist(m_tagger_rand);
+    } while (player == RL_PLAYER_INDEX);
+    return player;
+}
+
+void TagArena::set_tag(int player) {
+    m_tag_player = player;
+    for (size_t i = 0; i < m_players.size(); i++) {
+        m_players[i].is_tagged = static_cast<int>(i) == player;
+    }
+}
+
+bool TagArena::is_tagging(int tagger, int player) const {
+    return m_config.player_radius + m_config.player_radius >= m_players[tagger].pos.distance(m_players[player].pos);
+}
+
+void TagArena::init_game() {
+    m_players.clear();
+    m_tag_player = -1;
+    m_tag_changed_time = -std::numeric_limits<double>::infinity();
+
+    for (int i = 0; i < m_config.player_count; i++) {
+        TagPlayer player;
+        player.pos = random_position();
+        player.max_velocity = m_config.max_velocity;
+        m_players.push_back(player);
+    }
+
+    set_tag(random_non_rl_player());
+
+    for (size_t i = 0; i < m_players.size(); i++) {
+        if (static_cast<int>(i) != m_tag_player && is_tagging(m_tag_player, i)) {
+            init_game();
+            return;
+        }
+    }
+}
+
+void TagArena::handle_tagging_logic() {
+    for (size_t i = 0; i < m_players.size(); i++) {
+        if (static_cast<int>(i) != m_tag_player && is_tagging(m_tag_player, i)) {
+            set_tag(i);
+            m_players[i].steering = Steering::Idle;
+            m_tag_changed_time = m_clock_ms;
+            return;
+        }
+    }
+}
+
+std::vector<Vec2> TagArena::corners_by_distance(const Vec2& pos) const {
+    std::vector<Vec2> corners = m_corners;
+    std::stable_sort(corners.begin(), corners.end(),
+                     [&pos](const Vec2& a, const Vec2& b) { return pos.distance(a) < pos.distance(b); });
+    return corners;
+}
+
+Vec2 TagArena::dumb_tag_velocity(int me) const {
+    // DumbTagSteering is constructed with (float) (maxVelocity * 0.8f)
+    const double max_velocity = static_cast<float>(m_config.max_velocity * 0.8f);
+    const Vec2& my_position = m_players[me].pos;
+    Vec2 desired_velocity{0, 0};
+
+    if (m_players[me].is_tagged) {
+        int target = -1;
+        double closest_distance = std::numeric_limits<double>::max();
+
+        for (size_t i = 0; i < m_players.size(); i++) {
+            if (static_cast<int>(i) == me) continue;
+
+            const Vec2& opponent_position = m_players[i].pos;
+            double distance = my_position.distance(opponent_position);
+            double corner_weight =
+                std::max(0.0, 1.0 - (opponent_position.distance(corners_by_distance(opponent_position)[0]) /
+                                     m_chasing_corner_distance_threshold));
+
+            if (distance - corner_weight * m_corner_weight_multiplier < closest_distance) {
+                closest_distance = distance;
+                target = i;
+            }
+        }
+
+        if (target >= 0) {
+            desired_velocity = (m_players[target].pos - my_position).normalize() * max_velocity;
+        }
+    } else {
+        int tagged_opponent = -1;
+        for (size_t i = 0; i < m_players.size(); i++) {
+            if (static_cast<int>(i) != me && m_players[i].is_tagged) {
+                tagged_opponent = i;
+                break;
+            }
+        }
+
+        if (tagged_opponent >= 0) {
+            const Vec2& opponent_position = m_players[tagged_opponent].pos;
+            double distance_to_opponent = my_position.distance(opponent_position);
+
+            double flee_weight =
+                std::max(0.0, (m_safe_distance_threshold - distance_to_opponent) / m_safe_distance_threshold);
+            double seek_weight = 1.0 - flee_weight;
+            Vec2 furthest_corner = corners_by_distance(opponent_position).back();
+
+            Vec2 desired_direction = (furthest_corner - my_position).normalize();
+            Vec2 from_me_to_opponent = (opponent_position - my_position).normalize();
+            desired_velocity = desired_direction * seek_weight + from_me_to_opponent * -flee_weight;
+
+            desired_velocity = desired_velocity.normalize() * max_velocity;
+        }
+    }
+
+    return desired_velocity;
+}
+
+void TagArena::update_player(int i, float time) {
+    TagPlayer& player = m_players[i];
+
+    Vec2 velocity{0, 0};
+    if (player.steering == Steering::Action) {
+        velocity = player.action;
+    } else if (player.steering == Steering::DumbTag) {
+        velocity = dumb_tag_velocity(i);
+    }
+
+    if (velocity.norm() > player.max_velocity) {
+        velocity = velocity.normalize() * player.max_velocity;
+    }
+    player.velocity = velocity;
+
+    // Only cancel out velocity components trying to move out of bounds
+    Vec2 bounded = velocity;
+    if ((player.pos.x + m_config.player_radius >= m_config.width && velocity.x > 0) ||
+        (player.pos.x - m_config.player_radius <= 0 && velocity.x < 0)) {
+        bounded.x = 0;
+    }
+    if ((player.pos.y + m_config.player_radius >= m_config.height && velocity.y > 0) ||
+        (player.pos.y - m_config.player_radius <= 0 && velocity.y < 0)) {
+        bounded.y = 0;
+    }
+
+    player.pos = player.pos + bounded * static_cast<double>(time);
+}
+
+void TagArena::tick(bool reset, const Vec2& action) {
+    if (reset) {
+        init_game();
+    } else {
+        m_players[RL_PLAYER_INDEX].steering = Steering::Action;
+        m_players[RL_PLAYER_INDEX].action = action;
+    }
+
+    bool tagger_sleeping = m_clock_ms - m_tag_changed_time < m_config.tagger_sleep_time_ms;
+    if (!tagger_sleeping) {
+        m_players[m_tag_player].steering = Steering::DumbTag;
+        handle_tagging_logic();
+    }
+
+    const float time = m_config.tick_ms * m_config.time_coefficient;
+    for (size_t i = 0; i < m_players.size(); i++) {
+        update_player(i, time);
+    }
+
+    m_clock_ms += m_config.tick_ms;
+}
+
+void TagArena::save_state(StateWriter& writer) const {
+    writer.write_vector(m_players);
+    writer.write(m_tag_player);
+    writer.write(m_clock_ms);
+    writer.write(m_tag_changed_time);
+    writer.write(m_rand);  // the 48-bit LCG state
+    writer.write_engine(m_tagger_rand);
+}
+
+void TagArena::load_state(StateReader& reader) {
+    reader.read_vector(m_players);
+    if (static_cast<int>(m_players.size()) != m_config.player_count) {
+        throw std::runtime_error("player count differs from the saved arena");
+    }
+    m_tag_player = reader.read<int>();
+    m_clock_ms = reader.read<double>();
+    m_tag_changed_time = reader.read<double>();
+    m_rand = reader.read<JavaRandom>();
+    reader.read_engine(m_tagger_rand);
+}
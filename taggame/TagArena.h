@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "taggame/JavaRandom.h"
+
+class StateWriter;
+class StateReader;
+
+// Mirrors the constants of taggame-java's SlickGraphicsRunner so the in-process
+// arena behaves like the server the README tells you to run.
+struct TagGameConfig {
+    int width = 800;
+    int height = 800;
+    double player_radius = 10;
+    int player_count = 2;
+    float time_coefficient = 1;
+    float max_velocity = 1;
+    int tagger_sleep_time_ms = 1000;
+    int tick_ms = 16;  // fixed simulation timestep, the `time` argument of TagGame.updateGame
+    int64_t seed = 0;
+};
+
+struct Vec2 {
+    double x = 0;
+    double y = 0;
+
+    Vec2 operator+(const Vec2& o) const { return {x + o.x, y + o.y}; }
+    Vec2 operator-(const Vec2& o) const { return {x - o.x, y - o.y}; }
+    Vec2 operator*(double k) const { return {x * k, y * k}; }
+    double norm() const { return std::hypot(x, y); }
+    double distance(const Vec2& o) const { return std::hypot(o.x - x, o.y - y); }
+    Vec2 normalize() const {
+        double r = norm();
+        return {x / r, y / r};
+    }
+};
+
+enum class Steering { Idle, Action, DumbTag };
+
+struct TagPlayer {
+    Vec2 pos;
+    Vec2 velocity;
+    Vec2 action;  // velocity requested by the RL agent when steering is Action
+    double max_velocity;
+    bool is_tagged = false;
+    Steering steering = Steering::Idle;
+};
+
+// C++ port of TagGame.updateGame, TagPlayer.update and DumbTagSteering from
+// taggame-java. Wall-clock time is replaced by a simulated clock advanced by
+// `tick_ms` per tick.
+class TagArena {
+   protected:
+    static constexpr int RL_PLAYER_INDEX = 0;
+
+    TagGameConfig m_config;
+    std::vector<TagPlayer> m_players;
+    int m_tag_player;
+    double m_clock_ms;
+    double m_tag_changed_time;
+
+    JavaRandom m_rand;
+    std::mt19937 m_tagger_rand;
+
+    double m_safe_distance_threshold;
+    double m_chasing_corner_distance_threshold;
+    double m_corner_weight_multiplier;
+    std::vector<Vec2> m_corners;
+
+    Vec2 random_position();
+    int random_non_rl_player();
+    void set_tag(int player);
+    bool is_tagging(int tagger, int player) const;
+    void handle_tagging_logic();
+    std::vector<Vec2> corners_by_distance(const Vec2& pos) const;
+    Vec2 dumb_tag_velocity(int me) const;
+    void update_player(int i, float time);
+
+   public:
+    explicit TagArena(const TagGameConfig& config = {});
+
+    void seed(int64_t seed);
+    void init_game();
+    // One TagGame.updateGame call: `reset` mirrors the "reset" message, otherwise `action` steers the RL player.
+    void tick(bool reset, const Vec2& action = {});
+
+    const TagGameConfig& config() const { return m_config; }
+    const std::vector<TagPlayer>& players() const { return m_players; }
+    const TagPlayer& rl_player() const { return m_players[RL_PLAYER_INDEX]; }
+    const TagPlayer& tag_player() const { return m_players[m_tag_player]; }
+    bool rl_player_tagged() const { return m_tag_player == RL_PLAYER_INDEX; }
+
+    // Players, clock and both random streams; the configuration is not saved
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+};
@@ -8,13 +8,23 @@
 #include "m_utils.h"
 #include "taggame/TagGame.h"
 
-void TagGame::initialize() {
-    if (!m_communicator.connectToServer(TAGGAME_HOST, TAGGAME_PORT)) {
+void TagGame::initialize() { initialize(TransportConfig{}); }
+
+void TagGame::initialize(const TransportConfig& transport) {
+    if (!m_communicator.connect(transport)) {
         throw std::runtime_error(
             "Failed to initialize: Failed to connect to the TagGame! Please run the TagGame first and then the RL "
             "control.");
     }
 
+    initialize_actions();
+}
+
+bool TagGame::record_trace(const std::string& file_path) {
+    return m_communicator.startTrace(output_dir + file_path);
+}
+
+void TagGameBase::initialize_actions() {
     // Initialize all possible actions once
     m_all_actions.clear();
     for (int ax = -MAX_VELOCITY; ax <= MAX_VELOCITY; ++ax) {
@@ -24,9 +34,11 @@ void TagGame::initialize() {
             }
         }
     }
+    m_all_valid.assign(m_all_actions.size(), true);
+    invalidate_actions();
 }
 
-std::string TagGame::serialize_action(Action a) {
+std::string TagGameBase::serialize_action(Action a, int repeat) {
     nlohmann::json serialized_action;
 
     int x = std::get<0>(a);
@@ -34,46 +46,56 @@ std::string TagGame::serialize_action(Action a) {
 
     serialized_action["x"] = x;
     serialized_action["y"] = y;
+    if (repeat > 1) serialized_action["k"] = repeat;
 
     return serialized_action.dump();
 }
 
+State TagGameBase::parse_state(const std::string& str_state) {
+    nlohmann::json gameState = nlohmann::json::parse(str_state);
+
+    std::pair<int, int> myPosition(gameState["mp"][0], gameState["mp"][1]);
+    std::pair<int, int> myVelocity(gameState["mv"][0], gameState["mv"][1]);
+    std::pair<int, int> tagPosition(gameState["tp"][0], gameState["tp"][1]);
+    std::pair<int, int> tagVelocity(gameState["tv"][0], gameState["tv"][1]);
+    bool isTagged = gameState["t"];
+
+    return {myPosition, myVelocity, tagPosition, tagVelocity, isTagged};
+}
+
 State TagGame::deserialize_state(const std::string& str_state) {
     try {
-        nlohmann::json gameState = nlohmann::json::parse(str_state);
-
-        std::pair<int, int> myPosition(gameState["mp"][0], gameState["mp"][1]);
-        std::pair<int, int> myVelocity(gameState["mv"][0], gameState["mv"][1]);
-        std::pair<int, int> tagPosition(gameState["tp"][0], gameState["tp"][1]);
-        std::pair<int, int> tagVelocity(gameState["tv"][0], gameState["tv"][1]);
-        bool isTagged = gameState["t"];
+        State state = parse_state(str_state);
+        if (!m_communicator.isVerbose()) return state;
+        const auto& [myPosition, myVelocity, tagPosition, tagVelocity, isTagged] = state;
 
         std::cout << "Received: mp=[" << myPosition.first << ", " << myPosition.second << "], mv=[" << myVelocity.first
                   << ", " << myVelocity.second << "], tp=[" << tagPosition.first << ", " << tagPosition.second
                   << "], tv=[" << tagVelocity.first << ", " << tagVelocity.second << "], tagged=" << isTagged
                   << std::endl;
 
-        return {myPosition, myVelocity, tagPosition, tagVelocity, isTagged};
+        return state;
     } catch (const std::exception& e) {
         std::cerr << "Error parsing JSON: " << e.what() << std::endl;
         throw;
     }
 }
 
-bool TagGame::is_terminal(const State& s) {
+bool TagGameBase::is_terminal(const State& s) {
     return std::get<4>(s);  // Terminal if I am tagged (t is true)
 }
 
-Reward TagGame::calculate_reward(const State& old_s, const State& new_s) {
+Reward TagGameBase::calculate_reward(const State& old_s, const State& new_s) {
     auto [old_my_pos, old_my_vel, old_tag_pos, old_tag_vel, old_is_tagged] = old_s;
     auto [new_my_pos, new_my_vel, new_tag_pos, new_tag_vel, new_is_tagged] = new_s;
 
     if (new_is_tagged) {
-        return -1;
+        return TAGGED_REWARD;
     }
 
-    return 1;
+    return SURVIVAL_REWARD;
 }
+
 State TagGame::reset() {
     m_communicator.sendAction(m_communicator.RESET);
     return deserialize_state(m_communicator.receiveState());
@@ -88,6 +110,29 @@ std::pair<State, Reward> TagGame::step(const State& old_s, const Action& action)
     return {new_s, calculate_reward(old_s, new_s)};
 }
 
-std::vector<Action> TagGame::all_possible_actions() const { return m_all_actions; }
+// The server runs up to `repeat` ticks for one message and stops early when the agent
+// is tagged, so every tick but the last one earned the survival reward.
+std::tuple<State, Reward, TimeStep> TagGame::step_repeated(const State& old_s, const Action& action, int repeat,
+                                                           double discount_rate) {
+    m_communicator.sendAction(serialize_action(action, repeat));
+    std::string response = m_communicator.receiveState();
+    State new_s = deserialize_state(response);
+    TimeStep ticks = nlohmann::json::parse(response).value("n", 1);
+
+    return {new_s, repeated_reward(old_s, new_s, ticks, discount_rate), ticks};
+}
+
+Reward TagGameBase::repeated_reward(const State& old_s, const State& new_s, TimeStep ticks, double discount_rate) {
+    Reward total = 0;
+    double discount = 1;
+    for (TimeStep i = 0; i + 1 < ticks; i++) {
+        total += discount * SURVIVAL_REWARD;
+        discount *= discount_rate;
+    }
+    total += discount * calculate_reward(old_s, new_s);
+    return total;
+}
+
+std::vector<Action> TagGameBase::all_possible_actions() const { return m_all_actions; }
 
-void TagGame::plot_policy(DeterministicPolicy<State, Action>& pi) {}
\ No newline at end of file
+void TagGameBase::plot_policy(DeterministicPolicy<State, Action>& pi) {}
\ No newline at end of file
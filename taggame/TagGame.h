@@ -6,6 +6,7 @@
 #include "Communicator.h"
 #include "MDP.h"
 #include "Policy.h"
+#include "StateCodec.h"
 #include "m_types.h"
 
 static constexpr double MAX_VELOCITY = 3;
@@ -13,30 +14,59 @@ static constexpr double MAX_X = 2000;
 static constexpr double MAX_Y = 2000;
 static const double MAX_DISTANCE = std::sqrt(MAX_X * MAX_X + MAX_Y * MAX_Y);
 
-static const std::string TAGGAME_HOST = "127.0.0.1";
-static const int TAGGAME_PORT = 12345;
+static constexpr Reward SURVIVAL_REWARD = 1;
+static constexpr Reward TAGGED_REWARD = -1;
 
 // (myPosition, myVelocity, tagPosition, tagVelocity, isTagged)
 using State = std::tuple<std::pair<int, int>, std::pair<int, int>, std::pair<int, int>, std::pair<int, int>, bool>;
 // the x and y components of the velocity vector
 using Action = std::pair<int, int>;
 
-class TagGame : public MDP<State, Action> {
+// Bit-packed keys for State (57 bits) and Action (6 bits). Positions get 11 bits, enough for
+// [0, MAX_X) plus one 16 ms step at MAX_VELOCITY past the left/top wall.
+using PositionBounds = Bounds<-48, 1999>;
+using VelocityBounds = Bounds<-static_cast<int64_t>(MAX_VELOCITY), static_cast<int64_t>(MAX_VELOCITY)>;
+using PackedState =
+    PackedCodec<State, Fields<Fields<PositionBounds, PositionBounds>, Fields<VelocityBounds, VelocityBounds>,
+                              Fields<PositionBounds, PositionBounds>, Fields<VelocityBounds, VelocityBounds>, Bounds<0, 1>>>;
+using PackedAction = PackedCodec<Action, Fields<VelocityBounds, VelocityBounds>>;
+
+// State, actions and rewards shared by every TagGame environment; subclasses
+// decide where the states come from
+class TagGameBase : public MDP<State, Action> {
    protected:
-    Communicator &m_communicator;
     std::vector<Action> m_all_actions;
+    ActionMask m_all_valid;  // every action is valid in every state
+
+    void initialize_actions();
+    // Reward of `ticks` repeated ticks: survival on each tick but the last, which ends in new_s
+    Reward repeated_reward(const State &old_s, const State &new_s, TimeStep ticks, double discount_rate);
 
    public:
-    TagGame() : MDP(), m_communicator(Communicator::getInstance()) {}
-    virtual ~TagGame() { Communicator::getInstance().disconnect(); };
-    void initialize() override;
     bool is_terminal(const State &s) override;
     bool is_valid(const State &s, const Action &a) const override { return true; };
-    std::string serialize_action(Action);
-    State deserialize_state(const std::string &);
+    const ActionMask *action_mask(const State &) const override { return &m_all_valid; }
+    std::string serialize_action(Action, int repeat = 1);
+    static State parse_state(const std::string &);
     Reward calculate_reward(const State &, const State &);
-    State reset() override;
-    std::pair<State, Reward> step(const State &, const Action &) override;
     std::vector<Action> all_possible_actions() const override;
     void plot_policy(DeterministicPolicy<State, Action> &);
 };
+
+// TagGame played by the Java server over a transport
+class TagGame : public TagGameBase {
+   protected:
+    Communicator &m_communicator;
+
+   public:
+    TagGame() : TagGameBase(), m_communicator(Communicator::getInstance()) {}
+    virtual ~TagGame() { Communicator::getInstance().disconnect(); };
+    void initialize() override;  // over TCP to TAGGAME_HOST:TAGGAME_PORT
+    void initialize(const TransportConfig &transport);
+    // Records the traffic with the game to output_dir + file_path, for replay with ReplayTagGame
+    bool record_trace(const std::string &file_path);
+    State deserialize_state(const std::string &);
+    State reset() override;
+    std::pair<State, Reward> step(const State &, const Action &) override;
+    std::tuple<State, Reward, TimeStep> step_repeated(const State &, const Action &, int repeat, double discount_rate);
+};
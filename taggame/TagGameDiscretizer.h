@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "taggame/TagArena.h"
+#include "taggame/TagGame.h"
+
+// How TagGameDiscretizer aggregates a state. Every mode keeps coarse bins of the
+// agent's own position (where the walls are) and the direction the tagger moves in.
+enum class DiscretizationMode {
+    Uniform,      // both players' positions in uniform bins
+    LogDistance,  // distance to the tagger in log-scale bins, bearing in angular sectors
+    Relative      // tagger position relative to the agent in uniform bins
+};
+
+struct TagGameDiscretizerConfig {
+    DiscretizationMode mode = DiscretizationMode::LogDistance;
+    int width = TagGameConfig{}.width;
+    int height = TagGameConfig{}.height;
+    int position_bins = 4;  // per axis
+    int distance_bins = 6;  // LogDistance
+    int angle_bins = 8;     // LogDistance
+    int relative_bins = 8;  // per axis, Relative
+};
+
+// Maps TagGame states to keys in [0, size()) for DiscretizedValueStrategy
+class TagGameDiscretizer {
+   private:
+    static constexpr int VELOCITY_DIRECTIONS = 9;  // sign of each tagger velocity component
+
+    TagGameDiscretizerConfig m_config;
+
+    static int bin(double value, double lo, double hi, int bins) {
+        int b = static_cast<int>((value - lo) / (hi - lo) * bins);
+        return std::clamp(b, 0, bins - 1);
+    }
+
+    static int sign(int v) { return (v > 0) - (v < 0); }
+
+    size_t feature_bins() const {
+        switch (m_config.mode) {
+            case DiscretizationMode::Uniform:
+                return static_cast<size_t>(m_config.position_bins) * m_config.position_bins;
+            case DiscretizationMode::LogDistance:
+                return static_cast<size_t>(m_config.distance_bins) * m_config.angle_bins;
+            case DiscretizationMode::Relative:
+                return static_cast<size_t>(m_config.relative_bins) * m_config.relative_bins;
+        }
+        return 0;
+    }
+
+    // Index of the tagger-dependent features, in [0, feature_bins())
+    size_t feature(const std::pair<int, int>& me, const std::pair<int, int>& tagger) const {
+        double dx = tagger.first - me.first;
+        double dy = tagger.second - me.second;
+
+        switch (m_config.mode) {
+            case DiscretizationMode::Uniform:
+                return bin(tagger.first, 0, m_config.width, m_config.position_bins) * m_config.position_bins +
+                       bin(tagger.second, 0, m_config.height, m_config.position_bins);
+            case DiscretizationMode::LogDistance: {
+                double max_distance = std::hypot(m_config.width, m_config.height);
+                int distance = bin(std::log1p(std::hypot(dx, dy)), 0, std::log1p(max_distance), m_config.distance_bins);
+                int angle = bin(std::atan2(dy, dx), -M_PI, M_PI, m_config.angle_bins);
+                return distance * m_config.angle_bins + angle;
+            }
+            case DiscretizationMode::Relative:
+                return bin(dx, -m_config.width, m_config.width, m_config.relative_bins) * m_config.relative_bins +
+                       bin(dy, -m_config.height, m_config.height, m_config.relative_bins);
+        }
+        return 0;
+    }
+
+   public:
+    explicit TagGameDiscretizer(const TagGameDiscretizerConfig& config = {}) : m_config(config) {}
+
+    size_t size() const {
+        return static_cast<size_t>(m_config.position_bins) * m_config.position_bins * feature_bins() *
+               VELOCITY_DIRECTIONS;
+    }
+
+    size_t operator()(const State& s) const {
+        const auto& [my_pos, my_vel, tag_pos, tag_vel, is_tagged] = s;
+
+        size_t own = bin(my_pos.first, 0, m_config.width, m_config.position_bins) * m_config.position_bins +
+                     bin(my_pos.second, 0, m_config.height, m_config.position_bins);
+        size_t direction = (sign(tag_vel.first) + 1) * 3 + (sign(tag_vel.second) + 1);
+
+        return (own * feature_bins() + feature(my_pos, tag_pos)) * VELOCITY_DIRECTIONS + direction;
+    }
+
+    const TagGameDiscretizerConfig& config() const { return m_config; }
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "taggame/TagGame.h"
+
+// Features of the linear TagGame approximator, shared by the FA training solution
+// and the deployed agent that plays with its weights
+static constexpr int TAGGAME_FEATURE_COUNT = 6;
+
+inline std::vector<double> taggame_features(const State& s, const Action& a) {
+    const auto& [my_pos, my_vel, tag_pos, tag_vel, is_tagged] = s;
+    const auto& [action_x, action_y] = a;
+
+    std::vector<double> features;
+
+    // Raw direction and distance data
+    double dx = (my_pos.first - tag_pos.first);
+    double dy = (my_pos.second - tag_pos.second);
+    double distance = std::sqrt(dx * dx + dy * dy);
+
+    // Normalized direction to tagger (unit vector)
+    double dir_magnitude = std::max(0.0001, std::sqrt(dx * dx + dy * dy));  // Avoid division by zero
+    double dir_x = dx / dir_magnitude;
+    double dir_y = dy / dir_magnitude;
+
+    // Normalized action
+    double action_magnitude = std::max(0.0001, std::sqrt(action_x * action_x + action_y * action_y));
+    double norm_action_x = action_x / action_magnitude;
+    double norm_action_y = action_y / action_magnitude;
+
+    // Moving away from tagger (-1 to 1)
+    double moving_away = norm_action_x * dir_x + norm_action_y * dir_y;
+
+    // Speed calculation
+    double my_speed = std::sqrt(my_vel.first * my_vel.first + my_vel.second * my_vel.second);
+    double tag_speed = std::sqrt(tag_vel.first * tag_vel.first + tag_vel.second * tag_vel.second);
+
+    // All push_backs in a row at the end
+    features.push_back(moving_away);
+    features.push_back(distance / MAX_DISTANCE);
+    features.push_back((my_speed - tag_speed) / MAX_VELOCITY);
+    features.push_back(action_magnitude / MAX_VELOCITY);
+    features.push_back(my_pos.first / MAX_X);
+    features.push_back(my_pos.second / MAX_Y);
+
+    return features;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdexcept>
+#include <utility>
+
+#include "taggame/TagArena.h"
+#include "taggame/TagGame.h"
+
+// The 8 symmetries of the square arena (the dihedral group D4). Transform g has
+// bit 0 = swap the x and y axes, bit 1 = mirror x, bit 2 = mirror y, applied in
+// that order. Positions mirror about the arena centre, velocities and actions
+// only change sign. The game reports positions rounded up, so the cell (p - 1, p]
+// mirrors to [size - p, size + 1 - p), which rounds up to size + 1 - p. The tagger's corner-based steering is symmetric under all 8.
+class TagGameSymmetry {
+   private:
+    int m_size;
+
+    static bool swaps(int g) { return g & 1; }
+    static bool mirrors_x(int g) { return g & 2; }
+    static bool mirrors_y(int g) { return g & 4; }
+
+    std::pair<int, int> position(int g, std::pair<int, int> p) const {
+        if (swaps(g)) std::swap(p.first, p.second);
+        if (mirrors_x(g)) p.first = m_size + 1 - p.first;
+        if (mirrors_y(g)) p.second = m_size + 1 - p.second;
+        return p;
+    }
+
+    static std::pair<int, int> vector(int g, std::pair<int, int> v) {
+        if (swaps(g)) std::swap(v.first, v.second);
+        if (mirrors_x(g)) v.first = -v.first;
+        if (mirrors_y(g)) v.second = -v.second;
+        return v;
+    }
+
+   public:
+    static constexpr int ORDER = 8;
+
+    explicit TagGameSymmetry(const TagGameConfig& config = {}) : m_size(config.width) {
+        if (config.width != config.height) {
+            throw std::invalid_argument("TagGameSymmetry requires a square arena");
+        }
+    }
+
+    State apply(int g, const State& s) const {
+        const auto& [my_pos, my_vel, tag_pos, tag_vel, is_tagged] = s;
+        return {position(g, my_pos), vector(g, my_vel), position(g, tag_pos), vector(g, tag_vel), is_tagged};
+    }
+
+    Action apply(int g, const Action& a) const { return vector(g, a); }
+
+    Action invert(int g, Action a) const {
+        if (mirrors_y(g)) a.second = -a.second;
+        if (mirrors_x(g)) a.first = -a.first;
+        if (swaps(g)) std::swap(a.first, a.second);
+        return a;
+    }
+
+    // The lexicographically smallest of the 8 images of s, and the transform that produces it
+    std::pair<State, int> canonical(const State& s) const {
+        State best = s;
+        int best_g = 0;
+        for (int g = 1; g < ORDER; g++) {
+            State image = apply(g, s);
+            if (image < best) {
+                best = image;
+                best_g = g;
+            }
+        }
+        return {best, best_g};
+    }
+};
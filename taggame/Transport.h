@@ -0,0 +1,431 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+static const std::string TAGGAME_HOST = "127.0.0.1";
+static const int TAGGAME_PORT = 12345;
+static const std::string TAGGAME_SOCKET_PATH = "/tmp/taggame.sock";
+static const std::string TAGGAME_SHM_PATH = "/dev/shm/taggame";
+
+// How the agent reaches the game. The Java game must be started with the same
+// transport: -Dtaggame.transport=tcp|unix|shm and -Dtaggame.transport.path=<path>.
+enum class TransportKind { Tcp, Unix, SharedMemory };
+
+struct TransportConfig {
+    TransportKind kind = TransportKind::Tcp;
+    std::string host = TAGGAME_HOST;  // Tcp
+    int port = TAGGAME_PORT;          // Tcp
+    std::string path;                 // Unix and SharedMemory; empty for the default path
+    int spin_iterations = 10000;      // SharedMemory: polls before yielding the CPU
+    bool verbose = true;              // log every message to stdout
+};
+
+// Exchanges newline-free messages with the game, one per send/receive.
+// Failures, including the game going away, throw std::runtime_error.
+class Transport {
+   public:
+    virtual ~Transport() = default;
+    virtual void send(const std::string& message) = 0;
+    virtual std::string receive() = 0;
+};
+
+// Newline-framed messages over a connected stream socket. A receive may return
+// several messages or part of one; complete messages are handed out one at a
+// time and the rest is kept for the next receive().
+class SocketTransport : public Transport {
+   private:
+    int m_fd;
+    std::string m_in;
+    size_t m_in_begin{0};  // m_in before this was already returned
+    std::string m_out;
+
+   public:
+    explicit SocketTransport(int fd) : m_fd(fd) {}
+    ~SocketTransport() override { ::close(m_fd); }
+    SocketTransport(const SocketTransport&) = delete;
+    SocketTransport& operator=(const SocketTransport&) = delete;
+
+    // One write per message, so TCP_NODELAY sends it as one segment
+    void send(const std::string& message) override {
+        m_out.assign(message);
+        m_out.push_back('\n');
+        const char* data = m_out.data();
+        size_t left = m_out.size();
+        while (left > 0) {
+            ssize_t sent = ::send(m_fd, data, left, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Error sending message.");
+            }
+            data += sent;
+            left -= sent;
+        }
+    }
+
+    std::string receive() override {
+        size_t searched = m_in_begin;
+        while (true) {
+            size_t end = m_in.find('\n', searched);
+            if (end != std::string::npos) {
+                size_t begin = m_in_begin;
+                m_in_begin = end + 1;
+                if (end > begin && m_in[end - 1] == '\r') end--;
+                return m_in.substr(begin, end - begin);
+            }
+
+            m_in.erase(0, m_in_begin);
+            m_in_begin = 0;
+            searched = m_in.size();
+            char chunk[4096];
+            ssize_t received = ::recv(m_fd, chunk, sizeof(chunk), 0);
+            if (received == 0) throw std::runtime_error("Server closed the connection.");
+            if (received < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Error receiving message.");
+            }
+            m_in.append(chunk, received);
+        }
+    }
+};
+
+inline std::unique_ptr<Transport> connect_tcp(const std::string& host, int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error("Socket creation failed.");
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1 ||
+        ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        throw std::runtime_error("Connection to " + host + ":" + std::to_string(port) + " failed.");
+    }
+    // Every message is one small write answered by the other side, so Nagle's algorithm only adds delay
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return std::make_unique<SocketTransport>(fd);
+}
+
+inline std::unique_ptr<Transport> connect_unix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error("Socket creation failed.");
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        throw std::runtime_error("Connection to " + path + " failed.");
+    }
+    return std::make_unique<SocketTransport>(fd);
+}
+
+namespace shm_detail {
+
+constexpr uint32_t MAGIC = 0x4d534c52;  // "RLSM" in little-endian byte order
+constexpr uint32_t VERSION = 2;
+constexpr uint64_t DEFAULT_CAPACITY = 1 << 16;
+constexpr size_t LINE = 64;  // positions written by different sides live on separate cache lines
+
+// File layout, in native byte order:
+//   [0, LINE)  magic (u32), version (u32), ring capacity (u64), game closed (u64), agent closed (u64),
+//              attach request (u64), attached (u64)
+//   ring 0 (agent to game), then ring 1 (game to agent), each:
+//     write position (u64, own line), read position (u64, own line), capacity data bytes
+// Positions count bytes ever written/read; a message is a u32 length and its bytes,
+// wrapping around the data. The writer publishes it by advancing the write position.
+//
+// An agent attaches by incrementing the attach request and waiting until the game
+// copies it to `attached`. Before it does, the game zeroes all four positions and the
+// agent closed flag, so every agent starts on empty rings, whatever the previous one
+// left behind.
+constexpr size_t CAPACITY_OFFSET = 8;
+constexpr size_t GAME_CLOSED_OFFSET = 16;
+constexpr size_t AGENT_CLOSED_OFFSET = 24;
+constexpr size_t ATTACH_OFFSET = 32;
+constexpr size_t ATTACHED_OFFSET = 40;
+constexpr size_t HEADER_SIZE = LINE;
+constexpr size_t RING_HEADER_SIZE = 2 * LINE;
+
+inline size_t ring_offset(int ring, uint64_t capacity) { return HEADER_SIZE + ring * (RING_HEADER_SIZE + capacity); }
+inline size_t file_size(uint64_t capacity) { return ring_offset(2, capacity); }
+
+// Tells the CPU this is a spin-wait loop, like Java's Thread.onSpinWait()
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free,
+              "positions are shared with another process as plain 64-bit words");
+
+}  // namespace shm_detail
+
+// Single-producer, single-consumer rings in a memory-mapped file, one per direction,
+// for an agent and a game on the same host. A waiting side polls the other side's
+// position: it spins first (the reply to a step usually arrives within microseconds),
+// then yields the CPU, and sleeps between polls once the peer has been idle for a while.
+// There is no futex wake-up because the JVM cannot wait on one. Each side has its own
+// closed flag, so an agent can disconnect and a new one attach to the same game; the
+// Java game then waits for the next agent, while this class's game side (used by the
+// transport benchmark) stops.
+class SharedMemoryTransport : public Transport {
+   private:
+    struct Ring {
+        std::atomic<uint64_t>* write;
+        std::atomic<uint64_t>* read;
+        char* data;
+    };
+
+    char* m_base;
+    size_t m_size;
+    uint64_t m_capacity;
+    bool m_game_side;
+    std::atomic<uint64_t>* m_game_closed;
+    std::atomic<uint64_t>* m_agent_closed;
+    std::atomic<uint64_t>* m_attach;
+    std::atomic<uint64_t>* m_attached;
+    Ring m_out;
+    Ring m_in;
+    int m_spin_iterations;
+
+    static constexpr std::chrono::milliseconds IDLE_BEFORE_SLEEP{100};
+    static constexpr std::chrono::seconds ATTACH_TIMEOUT{5};
+
+    std::atomic<uint64_t>* word(size_t offset) const { return reinterpret_cast<std::atomic<uint64_t>*>(m_base + offset); }
+
+    Ring ring(int index) const {
+        char* at = m_base + shm_detail::ring_offset(index, m_capacity);
+        return {reinterpret_cast<std::atomic<uint64_t>*>(at),
+                reinterpret_cast<std::atomic<uint64_t>*>(at + shm_detail::LINE), at + shm_detail::RING_HEADER_SIZE};
+    }
+
+    // Game side: empties the rings for the agent that asked to attach, then lets it in
+    void accept_agent(uint64_t request) {
+        for (const Ring& r : {m_in, m_out}) {
+            r.write->store(0, std::memory_order_relaxed);
+            r.read->store(0, std::memory_order_relaxed);
+        }
+        m_agent_closed->store(0, std::memory_order_relaxed);
+        m_attached->store(request, std::memory_order_release);
+    }
+
+    // Waits until ready() holds; throws once the peer has closed. On the game side,
+    // returns false instead if a new agent attached, which resets the rings.
+    template <typename Ready>
+    bool wait(Ready ready) {
+        for (int i = 0; i < m_spin_iterations; i++) {
+            if (ready()) return true;
+            shm_detail::cpu_relax();
+        }
+        auto idle_since = std::chrono::steady_clock::now();
+        while (!ready()) {
+            if (m_game_side) {
+                uint64_t request = m_attach->load(std::memory_order_acquire);
+                if (request != m_attached->load(std::memory_order_relaxed)) {
+                    accept_agent(request);
+                    return false;
+                }
+                if (m_agent_closed->load(std::memory_order_acquire)) throw std::runtime_error("Agent closed the connection.");
+            } else if (m_game_closed->load(std::memory_order_acquire)) {
+                throw std::runtime_error("Server closed the connection.");
+            }
+            if (std::chrono::steady_clock::now() - idle_since < IDLE_BEFORE_SLEEP) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        return true;
+    }
+
+    // Agent side: asks the game for empty rings and waits until it has reset them
+    void attach(const std::string& path) {
+        uint64_t request = m_attach->fetch_add(1, std::memory_order_acq_rel) + 1;
+        auto deadline = std::chrono::steady_clock::now() + ATTACH_TIMEOUT;
+        while (m_attached->load(std::memory_order_acquire) != request) {
+            if (m_game_closed->load(std::memory_order_acquire)) {
+                throw std::runtime_error(path + " was closed, restart the game.");
+            }
+            if (std::chrono::steady_clock::now() > deadline) {
+                throw std::runtime_error("The game did not answer on " + path + ", is it running?");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void copy_in(const Ring& r, uint64_t position, const char* bytes, size_t size) {
+        size_t offset = position & (m_capacity - 1);
+        size_t first = std::min<size_t>(size, m_capacity - offset);
+        std::memcpy(r.data + offset, bytes, first);
+        std::memcpy(r.data, bytes + first, size - first);
+    }
+
+    void copy_out(const Ring& r, uint64_t position, char* bytes, size_t size) const {
+        size_t offset = position & (m_capacity - 1);
+        size_t first = std::min<size_t>(size, m_capacity - offset);
+        std::memcpy(bytes, r.data + offset, first);
+        std::memcpy(bytes + first, r.data, size - first);
+    }
+
+    SharedMemoryTransport(char* base, size_t size, bool game_side, int spin_iterations)
+        : m_base(base),
+          m_size(size),
+          m_game_side(game_side),
+          m_spin_iterations(spin_iterations) {
+        using namespace shm_detail;
+        std::memcpy(&m_capacity, base + CAPACITY_OFFSET, sizeof(m_capacity));
+        m_game_closed = word(GAME_CLOSED_OFFSET);
+        m_agent_closed = word(AGENT_CLOSED_OFFSET);
+        m_attach = word(ATTACH_OFFSET);
+        m_attached = word(ATTACHED_OFFSET);
+        m_out = ring(game_side ? 1 : 0);
+        m_in = ring(game_side ? 0 : 1);
+    }
+
+    static char* map(int fd, size_t size) {
+        void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) throw std::runtime_error("Failed to map the shared memory file.");
+        return static_cast<char*>(base);
+    }
+
+   public:
+    // Opens the file created by the game and takes the agent's side
+    static std::unique_ptr<SharedMemoryTransport> open(const std::string& path, int spin_iterations) {
+        using namespace shm_detail;
+        int fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0) throw std::runtime_error("Failed to open " + path + ", is the game running?");
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < HEADER_SIZE) {
+            ::close(fd);
+            throw std::runtime_error(path + " is not a TagGame shared memory file.");
+        }
+        size_t size = info.st_size;
+        char* base = map(fd, size);
+
+        // Pairs with the game's release store, so the fields below are initialized
+        uint32_t magic = reinterpret_cast<std::atomic<uint32_t>*>(base)->load(std::memory_order_acquire);
+        uint32_t version;
+        uint64_t capacity;
+        std::memcpy(&version, base + 4, sizeof(version));
+        std::memcpy(&capacity, base + CAPACITY_OFFSET, sizeof(capacity));
+        if (magic != MAGIC || version != VERSION || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+            size != file_size(capacity)) {
+            ::munmap(base, size);
+            throw std::runtime_error(path + " is not a TagGame shared memory file of version " +
+                                     std::to_string(VERSION) + ".");
+        }
+        auto transport = std::unique_ptr<SharedMemoryTransport>(new SharedMemoryTransport(base, size, false, spin_iterations));
+        transport->attach(path);
+        return transport;
+    }
+
+    // Creates the file and takes the game's side; the Java game does the same in SharedMemoryTransport.java
+    static std::unique_ptr<SharedMemoryTransport> create(const std::string& path, int spin_iterations,
+                                                         uint64_t capacity = shm_detail::DEFAULT_CAPACITY) {
+        using namespace shm_detail;
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("Ring capacity must be a power of two.");
+        }
+        size_t size = file_size(capacity);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0 || ::ftruncate(fd, size) != 0) {
+            if (fd >= 0) ::close(fd);
+            throw std::runtime_error("Failed to create " + path + ".");
+        }
+        char* base = map(fd, size);
+        std::memcpy(base + CAPACITY_OFFSET, &capacity, sizeof(capacity));
+        std::memcpy(base + 4, &VERSION, sizeof(VERSION));
+        // The magic goes last, so an agent never sees a half-initialized file as valid
+        reinterpret_cast<std::atomic<uint32_t>*>(base)->store(MAGIC, std::memory_order_release);
+        return std::unique_ptr<SharedMemoryTransport>(new SharedMemoryTransport(base, size, true, spin_iterations));
+    }
+
+    ~SharedMemoryTransport() override {
+        (m_game_side ? m_game_closed : m_agent_closed)->store(1, std::memory_order_release);
+        ::munmap(m_base, m_size);
+    }
+    SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+    SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+    void send(const std::string& message) override {
+        uint32_t length = message.size();
+        uint64_t size = sizeof(length) + length;
+        if (size > m_capacity) throw std::runtime_error("Message larger than the shared memory ring.");
+
+        uint64_t position = m_out.write->load(std::memory_order_relaxed);
+        // A new agent replaced the one this message was for
+        if (!wait([&] { return position + size - m_out.read->load(std::memory_order_acquire) <= m_capacity; })) return;
+        copy_in(m_out, position, reinterpret_cast<const char*>(&length), sizeof(length));
+        copy_in(m_out, position + sizeof(length), message.data(), length);
+        m_out.write->store(position + size, std::memory_order_release);
+    }
+
+    std::string receive() override {
+        uint64_t position;
+        do {
+            position = m_in.read->load(std::memory_order_relaxed);
+        } while (!wait([&] { return m_in.write->load(std::memory_order_acquire) != position; }));
+
+        uint32_t length;
+        copy_out(m_in, position, reinterpret_cast<char*>(&length), sizeof(length));
+        std::string message(length, '\0');
+        copy_out(m_in, position + sizeof(length), message.data(), length);
+        m_in.read->store(position + sizeof(length) + length, std::memory_order_release);
+        return message;
+    }
+};
+
+inline std::string transport_path(const TransportConfig& config) {
+    if (!config.path.empty()) return config.path;
+    return config.kind == TransportKind::Unix ? TAGGAME_SOCKET_PATH : TAGGAME_SHM_PATH;
+}
+
+inline std::string transport_description(const TransportConfig& config) {
+    switch (config.kind) {
+        case TransportKind::Tcp:
+            return "tcp " + config.host + ":" + std::to_string(config.port);
+        case TransportKind::Unix:
+            return "unix " + transport_path(config);
+        case TransportKind::SharedMemory:
+            return "shm " + transport_path(config);
+    }
+    return "";
+}
+
+// The agent's end of the configured transport
+inline std::unique_ptr<Transport> open_transport(const TransportConfig& config) {
+    switch (config.kind) {
+        case TransportKind::Tcp:
+            return connect_tcp(config.host, config.port);
+        case TransportKind::Unix:
+            return connect_unix(transport_path(config));
+        case TransportKind::SharedMemory:
+            return SharedMemoryTransport::open(transport_path(config), config.spin_iterations);
+    }
+    throw std::invalid_argument("Unknown transport");
+}
@@ -5,72 +5,44 @@
 #include <algorithm>
 #include <chrono>
 #include <exception>
+#include <filesystem>
 #include <functional>
 #include <iostream>
 #include <nlohmann/json.hpp>
 
+#include "AsyncCheckpointer.h"
 #include "FA_TD.h"
 #include "FunctionApproximator.h"
 #include "MDPSolver.h"
+#include "MDPWrappers.h"
 #include "Policy.h"
+#include "StateArchive.h"
 #include "ValueStrategy.h"
 #include "m_utils.h"
 #include "serialization.h"
 #include "taggame/TagGame.h"
+#include "taggame/TagGameFeatures.h"
 
 constexpr double DISCOUNT_RATE = 1;
 static constexpr long double N_OF_EPISODES = 50000;
+static constexpr int ACTION_REPEAT = 4;  // simulation ticks per agent decision
 static constexpr double POLICY_EPSILON = 0.1;
 static constexpr double TD_ALPHA = 0.001;
 static const std::string WEIGHTS_FILE = "taggame_fa_weights.json";
 static const std::string POLICY_FILE = "fa_td_taggame_optimal_policy.json";
+static const std::string TRAINING_STATE_FILE = "taggame_fa_td_training.state";
+static const CheckpointSchedule CHECKPOINT_SCHEDULE{1000, std::chrono::seconds(60)};
+
+// The Java game; SimulatedTagGame trains without it once taggame/sim_crosscheck.h
+// has matched it against a recorded Java trace
+using TagGameEnvironment = TagGame;
 
 inline int taggame_main() {
-    TagGame environment;
+    RecordEpisodeStatistics<ActionRepeat<TagGameEnvironment>> environment;
+    environment.set_action_repeat(ACTION_REPEAT);
     environment.initialize();
 
-    std::function<std::vector<double>(const State&, const Action&)> feature_extractor = [](const State& s,
-                                                                                           const Action& a) {
-        const auto& [my_pos, my_vel, tag_pos, tag_vel, is_tagged] = s;
-        const auto& [action_x, action_y] = a;
-
-        std::vector<double> features;
-
-        // Raw direction and distance data
-        double dx = (my_pos.first - tag_pos.first);
-        double dy = (my_pos.second - tag_pos.second);
-        double distance = std::sqrt(dx * dx + dy * dy);
-
-        // Normalized direction to tagger (unit vector)
-        double dir_magnitude = std::max(0.0001, std::sqrt(dx * dx + dy * dy));  // Avoid division by zero
-        double dir_x = dx / dir_magnitude;
-        double dir_y = dy / dir_magnitude;
-
-        // Normalized action
-        double action_magnitude = std::max(0.0001, std::sqrt(action_x * action_x + action_y * action_y));
-        double norm_action_x = action_x / action_magnitude;
-        double norm_action_y = action_y / action_magnitude;
-
-        // Moving away from tagger (-1 to 1)
-        double moving_away = norm_action_x * dir_x + norm_action_y * dir_y;
-
-        // Speed calculation
-        double my_speed = std::sqrt(my_vel.first * my_vel.first + my_vel.second * my_vel.second);
-        double tag_speed = std::sqrt(tag_vel.first * tag_vel.first + tag_vel.second * tag_vel.second);
-
-        // All push_backs in a row at the end
-        features.push_back(moving_away);
-        features.push_back(distance / MAX_DISTANCE);
-        features.push_back((my_speed - tag_speed) / MAX_VELOCITY);
-        features.push_back(action_magnitude / MAX_VELOCITY);
-        features.push_back(my_pos.first / MAX_X);
-        features.push_back(my_pos.second / MAX_Y);
-
-        return features;
-    };
-
-    int feature_dim = 6;  // Total number of features
-    auto approximator = new LinearFunctionApproximator<State, Action>(feature_dim, feature_extractor);
+    auto approximator = new LinearFunctionApproximator<State, Action>(TAGGAME_FEATURE_COUNT, taggame_features);
 
     auto value_strategy = new ApproximationValueStrategy<State, Action>();
     value_strategy->initialize(&environment, approximator);
@@ -88,16 +60,55 @@ inline int taggame_main() {
     EpsilonGreedyPolicy<State, Action> policy(value_strategy, POLICY_EPSILON);
     FA_TD<State, Action> mdp_solver(&environment, &policy, value_strategy, DISCOUNT_RATE, N_OF_EPISODES, TD_ALPHA);
 
+    // Continue an interrupted run exactly where it stopped; the weights file alone only warm-starts
+    if (std::filesystem::exists(output_dir + TRAINING_STATE_FILE) &&
+        load_training_state(output_dir + TRAINING_STATE_FILE, mdp_solver, environment)) {
+        std::cout << "Resuming training after episode " << mdp_solver.episode() << std::endl;
+    }
+
+    // Weights and the full learning state are copied between episodes and written by background threads
+    AsyncCheckpointer<std::vector<double>> checkpointer(
+        WEIGHTS_FILE, CHECKPOINT_SCHEDULE, [&]() { return approximator->get_weights(); }, save_weights,
+        [&](std::vector<double>& snapshot) { snapshot = approximator->get_weights(); });
+    AsyncCheckpointer<StateWriter> state_checkpointer(
+        TRAINING_STATE_FILE, CHECKPOINT_SCHEDULE,
+        [&]() {
+            StateWriter state;
+            capture_training_state(state, mdp_solver, environment);
+            return state;
+        },
+        write_training_state, [&](StateWriter& state) { capture_training_state(state, mdp_solver, environment); });
+    checkpointer.resume_from(mdp_solver.episode());
+    state_checkpointer.resume_from(mdp_solver.episode());
+    mdp_solver.set_episode_callback([&](int episode) {
+        checkpointer.on_episode_end(episode);
+        state_checkpointer.on_episode_end(episode);
+    });
+
+    bool completed = false;
     try {
         std::cout << "Starting policy iteration..." << std::endl;
         double time_taken = benchmark([&]() { mdp_solver.policy_iteration(); });
+        completed = true;
         std::cout << "Policy iteration completed in " << time_taken << " seconds." << std::endl;
+        std::cout << "Mean return over the last 100 episodes: " << environment.mean_return(100) << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "An exception occurred during policy iteration: " << e.what() << std::endl;
     } catch (...) {
         std::cerr << "An unknown exception occurred during policy iteration." << std::endl;
     }
 
+    checkpointer.flush();
+    state_checkpointer.flush();
+    std::cout << "Longest checkpoint pause: " << state_checkpointer.longest_pause() << " s" << std::endl;
+    // A finished run leaves nothing to resume, so the next launch trains anew
+    if (completed) {
+        std::filesystem::remove(output_dir + TRAINING_STATE_FILE);
+    } else {
+        write_atomically(TRAINING_STATE_FILE, [&](const std::string& path) {
+            return save_training_state(path, mdp_solver, environment);
+        });
+    }
     try {
         bool saved = save_approximator(approximator, WEIGHTS_FILE);
         if (saved) {
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "FunctionApproximator.h"
+#include "OfflineSolver.h"
+#include "TrajectoryRecorder.h"
+#include "m_utils.h"
+#include "serialization.h"
+#include "taggame/SimulatedTagGame.h"
+#include "taggame/TagGameFeatures.h"
+
+// Trains the FA solution's weights from transitions recorded by td_solution.h
+// (RECORD_TRAJECTORIES), without playing. The weights are saved to the same file
+// as fa_td_solution.h, so play_solution.h picks them up while it runs.
+constexpr double DISCOUNT_RATE = 1;
+static constexpr int ITERATIONS = 100;
+static constexpr double TOLERANCE = 1e-6;
+static constexpr OfflineTarget TARGET = OfflineTarget::FittedQ;
+static const std::string TRAJECTORY_FILE = "taggame_trajectories.bin";
+static const std::string WEIGHTS_FILE = "taggame_fa_weights.json";
+
+// The packed columns written by td_solution.h
+using TagGameTrajectoryReader = TrajectoryReader<State, Action, PackedState, PackedAction>;
+
+inline int taggame_main() {
+    // Only needed for the action set of the greedy targets
+    SimulatedTagGame environment;
+    environment.initialize();
+
+    try {
+        std::unique_ptr<TransitionBatch<State, Action>> batch;
+        double load_time = benchmark([&]() {
+            TagGameTrajectoryReader reader(output_dir + TRAJECTORY_FILE);
+            batch = std::make_unique<TransitionBatch<State, Action>>(reader);
+        });
+        std::cout << "Loaded " << batch->size() << " transitions in " << load_time << " seconds." << std::endl;
+
+        LinearFunctionApproximator<State, Action> approximator(TAGGAME_FEATURE_COUNT, taggame_features);
+        if (load_approximator(&approximator, output_dir + WEIGHTS_FILE)) {
+            std::cout << "Starting from the saved approximator weights." << std::endl;
+        }
+
+        OfflineConfig config;
+        config.discount_rate = DISCOUNT_RATE;
+        config.iterations = ITERATIONS;
+        config.tolerance = TOLERANCE;
+        int iterations = 0;
+        double time_taken = benchmark([&]() {
+            OfflineLinearSolver<State, Action> solver(*batch, &approximator, environment.all_actions(), config);
+            iterations = solver.solve(TARGET);
+        });
+        std::cout << iterations << " iterations completed in " << time_taken << " seconds ("
+                  << batch->size() * iterations / time_taken << " transitions per second)." << std::endl;
+
+        if (save_approximator(&approximator, WEIGHTS_FILE)) {
+            std::cout << "Successfully saved approximator weights to file." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Offline training failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "FunctionApproximator.h"
+#include "HotReload.h"
+#include "MDPWrappers.h"
+#include "ValueStrategy.h"
+#include "m_utils.h"
+#include "serialization.h"
+#include "taggame/TagGame.h"
+#include "taggame/TagGameFeatures.h"
+
+// Plays the Java TagGame greedily with the FA solution's weights. The weights file
+// is watched while the agent runs: a retrained or checkpointed file is swapped in
+// between two steps, without pausing the game or reconnecting.
+static constexpr int N_OF_EPISODES = 1000;
+static constexpr int ACTION_REPEAT = 4;
+static const std::string WEIGHTS_FILE = "taggame_fa_weights.json";
+static constexpr std::chrono::milliseconds WEIGHTS_POLL_INTERVAL{500};
+static constexpr TransportKind TRANSPORT = TransportKind::Tcp;  // must match -Dtaggame.transport of the game
+static constexpr bool RECORD_TRACE = false;  // traffic with the game, for replay with ReplayTagGame
+static const std::string TRACE_FILE = "taggame_trace.log";
+
+using TagGameApproximator = LinearFunctionApproximator<State, Action>;
+
+inline std::shared_ptr<TagGameApproximator> load_taggame_weights(const std::string& file_path) {
+    auto approximator = std::make_shared<TagGameApproximator>(TAGGAME_FEATURE_COUNT, taggame_features);
+    if (!load_approximator<State, Action>(approximator.get(), file_path)) return nullptr;
+    return approximator;
+}
+
+inline int taggame_main() {
+    ActionRepeat<TagGame> environment;
+    environment.set_action_repeat(ACTION_REPEAT);
+    TransportConfig transport;
+    transport.kind = TRANSPORT;
+    environment.initialize(transport);
+    if (RECORD_TRACE) environment.record_trace(TRACE_FILE);
+
+    HotReloader<TagGameApproximator> weights(output_dir + WEIGHTS_FILE, load_taggame_weights, WEIGHTS_POLL_INTERVAL);
+    std::shared_ptr<TagGameApproximator> approximator;
+    uint64_t weights_version = 0;
+    ApproximationValueStrategy<State, Action> greedy;
+
+    for (int episode = 1; episode <= N_OF_EPISODES; episode++) {
+        State s = environment.reset();
+        Return episode_return = 0;
+        int steps = 0;
+
+        while (!environment.is_terminal(s)) {
+            if (weights.refresh(approximator, weights_version) && approximator) {
+                std::cout << "Playing with weights version " << weights_version << std::endl;
+            }
+            if (!approximator) {
+                std::cerr << "No weights in " << output_dir + WEIGHTS_FILE << ", train with fa_td_solution.h first"
+                          << std::endl;
+                return 1;
+            }
+
+            Action a = std::get<0>(greedy.get_best_action_static(environment, *approximator, s));
+            auto [s_prime, r] = environment.step(s, a);
+            episode_return += r;
+            steps++;
+            s = s_prime;
+        }
+
+        std::cout << "Episode " << episode << ": return " << episode_return << " in " << steps << " decisions"
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "MDPWrappers.h"
+#include "serialization.h"
+#include "taggame/ReplayTagGame.h"
+#include "taggame/SimulatedTagGame.h"
+
+// Replays the action/state exchange logged by taggame-java's Communicator
+// ("Received action: ..." / "Sending state to RL agent: ...") or recorded with
+// TagGame::record_trace through the in-process simulator and reports the first
+// tick where the two disagree. The server must have been started with the same
+// seed and a fixed timestep (InMemoryRunner). No Java trace is checked in, so the
+// simulator has not yet been verified against the Java game; record one first.
+static const std::string JAVA_TRACE_FILE = "input/taggame_java_trace.log";
+static constexpr int64_t JAVA_TRACE_SEED = 0;
+
+inline std::string state_to_string(const State& s) {
+    const auto& [mp, mv, tp, tv, t] = s;
+    return "mp=" + key_to_string(mp) + " mv=" + key_to_string(mv) + " tp=" + key_to_string(tp) +
+           " tv=" + key_to_string(tv) + " t=" + (t ? "true" : "false");
+}
+
+inline int taggame_main() {
+    if (!std::filesystem::exists(JAVA_TRACE_FILE)) {
+        std::cerr << "No Java trace to check against: record " << JAVA_TRACE_FILE
+                  << " with InMemoryRunner (see README)" << std::endl;
+        return 1;
+    }
+    auto exchanges = read_taggame_trace(JAVA_TRACE_FILE);
+    if (exchanges.empty() || exchanges.front().first != Communicator::getInstance().RESET) {
+        std::cerr << "Trace must start with a reset: " << JAVA_TRACE_FILE << std::endl;
+        return 1;
+    }
+
+    TagGameConfig config;
+    config.seed = JAVA_TRACE_SEED;
+    ActionRepeat<SimulatedTagGame> environment(config);
+    environment.initialize();
+
+    State s;
+    for (size_t tick = 0; tick < exchanges.size(); tick++) {
+        const auto& [action_str, state_str] = exchanges[tick];
+
+        if (action_str == Communicator::getInstance().RESET) {
+            s = environment.reset();
+        } else {
+            nlohmann::json action = nlohmann::json::parse(action_str);
+            environment.set_action_repeat(action.value("k", 1));
+            s = environment.step(s, {action["x"], action["y"]}).first;
+        }
+
+        State expected = TagGame::parse_state(state_str);
+        if (s != expected) {
+            std::cerr << "Diverged at tick " << tick << std::endl
+                      << "  java:      " << state_to_string(expected) << std::endl
+                      << "  simulated: " << state_to_string(s) << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Simulator matches " << exchanges.size() << " recorded ticks." << std::endl;
+    return 0;
+}
@@ -4,40 +4,98 @@
 
 #include <chrono>
 #include <exception>
+#include <filesystem>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <nlohmann/json.hpp>
 
+#include "AsyncCheckpointer.h"
+#include "DiscretizedValueStrategy.h"
 #include "MDPSolver.h"
+#include "MDPWrappers.h"
 #include "Policy.h"
+#include "StateArchive.h"
 #include "TD.h"
-#include "ValueStrategy.h"
+#include "TrajectoryRecorder.h"
+#include "checkpoint.h"
 #include "m_utils.h"
+#include "Symmetry.h"
 #include "serialization.h"
 #include "taggame/TagGame.h"
+#include "taggame/TagGameDiscretizer.h"
+#include "taggame/TagGameSymmetry.h"
 
 constexpr double DISCOUNT_RATE = 1;
 static constexpr long double N_OF_EPISODES = 50000;
+static constexpr int ACTION_REPEAT = 4;  // simulation ticks per agent decision
 static constexpr double POLICY_EPSILON = 0.12;
 static constexpr double TD_ALPHA = 0.28;
-static const std::string Q_INPUT_FILE = "taggame_q_function.json";
-static const std::string POLICY_INPUT_FILE = "taggame_optimal_policy.json";
+static constexpr DiscretizationMode DISCRETIZATION = DiscretizationMode::LogDistance;
+static const std::string Q_INPUT_FILE = "taggame_q_function.bin";
+static const std::string Q_JSON_FILE = "taggame_q_function.json";  // for inspection only
+static const std::string TRAINING_STATE_FILE = "taggame_td_training.state";
+static constexpr bool RECORD_TRAJECTORIES = false;
+static const std::string TRAJECTORY_FILE = "taggame_trajectories.bin";
+static const CheckpointSchedule CHECKPOINT_SCHEDULE{1000, std::chrono::seconds(60)};
+
+using TagGameValueStrategy = DiscretizedValueStrategy<State, Action, TagGameDiscretizer>;
+using SymmetricTagGameValueStrategy = SymmetricValueStrategy<State, Action, TagGameValueStrategy, TagGameSymmetry>;
+// States take 8 bytes per column instead of 36 (see PackedState)
+using TagGameTrajectoryRecorder = TrajectoryRecorder<State, Action, PackedState, PackedAction>;
+
+// The Java game; SimulatedTagGame trains without it once taggame/sim_crosscheck.h
+// has matched it against a recorded Java trace
+using TagGameEnvironment = TagGame;
 
 inline int taggame_main() {
-    TagGame environment;
+    RecordEpisodeStatistics<RecordTrajectory<ActionRepeat<TagGameEnvironment>, TagGameTrajectoryRecorder>> environment;
+    environment.set_action_repeat(ACTION_REPEAT);
+    environment.initialize();
 
-    // Create a TabularValueStrategy
-    auto value_strategy = new TabularValueStrategy<State, Action>();
+    // Every decision for offline analysis and training, appended to across resumed runs
+    std::unique_ptr<TagGameTrajectoryRecorder> recorder;
+    if (RECORD_TRAJECTORIES) recorder = std::make_unique<TagGameTrajectoryRecorder>(TRAJECTORY_FILE, true);
+    environment.set_recorder(recorder.get());
+
+    // Raw positions and velocities never repeat, so Q is kept per discretized state
+    TagGameDiscretizerConfig discretization;
+    discretization.mode = DISCRETIZATION;
+    auto value_strategy = new TagGameValueStrategy(TagGameDiscretizer(discretization));
     value_strategy->initialize(&environment);
 
-    EpsilonGreedyPolicy<State, Action> policy(value_strategy, POLICY_EPSILON);
-    TD<State, Action> mdp_solver(&environment, &policy, value_strategy, DISCOUNT_RATE, N_OF_EPISODES, TD_ALPHA);
+    // Mirrored and rotated arena configurations share their Q values
+    auto symmetric_strategy = new SymmetricTagGameValueStrategy(value_strategy, TagGameSymmetry());
 
-    environment.initialize();
-    load_q_values(*value_strategy, output_dir + Q_INPUT_FILE);
+    EpsilonGreedyPolicy<State, Action> policy(symmetric_strategy, POLICY_EPSILON);
+    TD<State, Action, SymmetricTagGameValueStrategy> mdp_solver(&environment, &policy, symmetric_strategy,
+                                                                DISCOUNT_RATE, N_OF_EPISODES, TD_ALPHA);
 
+    // Continue an interrupted run exactly where it stopped, or warm-start from the last Q table
+    if (std::filesystem::exists(output_dir + TRAINING_STATE_FILE) &&
+        load_training_state(output_dir + TRAINING_STATE_FILE, mdp_solver, environment)) {
+        std::cout << "Resuming training after episode " << mdp_solver.episode() << std::endl;
+    } else {
+        load_q_checkpoint(*value_strategy, output_dir + Q_INPUT_FILE);
+    }
+
+    // The learning state (Q table, visit counts, episode, policy and arena RNGs) is
+    // serialized between episodes and written by a background thread
+    AsyncCheckpointer<StateWriter> checkpointer(
+        TRAINING_STATE_FILE, CHECKPOINT_SCHEDULE,
+        [&]() {
+            StateWriter state;
+            capture_training_state(state, mdp_solver, environment);
+            return state;
+        },
+        write_training_state, [&](StateWriter& state) { capture_training_state(state, mdp_solver, environment); });
+    checkpointer.resume_from(mdp_solver.episode());
+    mdp_solver.set_episode_callback([&](int episode) { checkpointer.on_episode_end(episode); });
+
+    bool completed = false;
     try {
         mdp_solver.policy_iteration();
+        completed = true;
     } catch (const std::exception& e) {
         std::cerr << "An exception occurred during policy iteration. Ignoring and proceeding: " << e.what()
                   << std::endl;
@@ -45,7 +103,21 @@ inline int taggame_main() {
         std::cerr << "An unknown exception occurred during policy iteration. Ignoring and proceeding." << std::endl;
     }
 
-    save_q_values(*value_strategy, Q_INPUT_FILE);
-    serialize_to_json(policy.optimal(), POLICY_INPUT_FILE);
+    value_strategy->report(std::cout);
+    std::cout << "Mean return over the last 100 episodes: " << environment.mean_return(100) << std::endl;
+
+    checkpointer.flush();
+    std::cout << "Longest checkpoint pause: " << checkpointer.longest_pause() << " s" << std::endl;
+    // A finished run leaves nothing to resume, so the next launch trains anew
+    if (completed) {
+        std::filesystem::remove(output_dir + TRAINING_STATE_FILE);
+    } else {
+        write_atomically(TRAINING_STATE_FILE, [&](const std::string& path) {
+            return save_training_state(path, mdp_solver, environment);
+        });
+    }
+    // The warm-start table is replaced only once the new one is complete
+    write_atomically(Q_INPUT_FILE, [&](const std::string& path) { return save_q_checkpoint(*value_strategy, path); });
+    save_q_values(*value_strategy, Q_JSON_FILE);
     return 0;
 }